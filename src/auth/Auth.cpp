@@ -21,20 +21,58 @@
 #include "Auth.h"
 #include "Constants.h"
 #include "AuthMessages.h"
-#include "SafeDataStream.h"
 
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
 #include <QtCore/QProcess>
+#include <QtCore/QThread>
 #include <QtCore/QUuid>
 #include <QtNetwork/QLocalServer>
 #include <QtNetwork/QLocalSocket>
 
 #include <QtQml/QtQml>
 
-#include <memory>
+#include <cstring>
+#include <limits>
 
 #include <unistd.h>
 
 namespace SDDM {
+    /**
+     * Connection to a single helper, living on the broker thread.
+     * It reassembles the frames and posts decoded messages to the
+     * Auth object of the helper.
+     */
+    class HelperConnection : public QObject {
+        Q_OBJECT
+    public:
+        HelperConnection(QLocalSocket *socket, QObject *parent);
+    public slots:
+        void send(const QByteArray &frame);
+    signals:
+        void hello(qint64 id);
+        void attached();
+        void error(const QString &message, Auth::Error type);
+        void info(const QString &message, Auth::Info type);
+        void request(const SDDM::Request &request);
+        void authenticated(const QString &user);
+        void sessionStatus(bool status);
+    private slots:
+        void readyRead();
+    private:
+        void process(const QByteArray &frame);
+
+        QLocalSocket *m_socket { nullptr };
+        QByteArray m_buffer;
+        bool m_identified { false };
+    };
+
+    /**
+     * Listens for helpers on a dedicated thread so that a stalled helper
+     * never blocks the main loop of the daemon.
+     */
     class Auth::SocketServer : public QLocalServer {
         Q_OBJECT
     public slots:
@@ -42,9 +80,17 @@ namespace SDDM {
     public:
         static SocketServer *instance();
 
-        QMap<qint64, Auth::Private*> helpers;
+        Q_INVOKABLE bool start(const QString &name);
+
+        void addHelper(qint64 id, Auth::Private *helper);
+        void removeHelper(qint64 id);
     private:
         SocketServer();
+        void attach(HelperConnection *connection, qint64 id);
+
+        // written from the main thread, read from the broker thread
+        QMutex m_mutex;
+        QMap<qint64, Auth::Private*> m_helpers;
     };
 
     class Auth::Private : public QObject {
@@ -52,21 +98,32 @@ namespace SDDM {
     public:
         Private(Auth *parent);
         ~Private();
-        void setSocket(QLocalSocket *socket);
+        void attach(HelperConnection *connection);
+    signals:
+        void send(const QByteArray &frame);
     public slots:
-        void dataPending();
+        void helperError(const QString &message, Auth::Error type);
+        void helperInfo(const QString &message, Auth::Info type);
+        void helperRequest(const SDDM::Request &r);
+        void helperAuthenticated(const QString &user);
+        void helperSessionStatus(bool status);
+        void helperConnected();
         void childExited(int exitCode, QProcess::ExitStatus exitStatus);
         void childError(QProcess::ProcessError error);
         void requestFinished();
+        void sendEnvironment();
     public:
         AuthRequest *request { nullptr };
         QProcess *child { nullptr };
-        QLocalSocket *socket { nullptr };
         QString sessionPath { };
         QString user { };
         QString cookie { };
         bool autologin { false };
         bool greeter { false };
+        bool environmentDeferred { false };
+        bool environmentPending { false };
+        bool environmentSent { false };
+        bool connected { false };
         QProcessEnvironment environment { };
         qint64 id { 0 };
         static qint64 lastId;
@@ -74,141 +131,278 @@ namespace SDDM {
 
     qint64 Auth::Private::lastId = 1;
 
+    // locale of the helper, /etc/locale.conf is parsed again only when it changed
+    static QProcessEnvironment localeEnvironment() {
+        static QProcessEnvironment cached;
+        static QDateTime cachedModified;
+        static qint64 cachedSize = -1;
 
+        QFileInfo info(QStringLiteral("/etc/locale.conf"));
+        const QDateTime modified = info.exists() ? info.lastModified() : QDateTime();
+        const qint64 size = info.exists() ? info.size() : -1;
+        if (!cached.isEmpty() && modified == cachedModified && size == cachedSize)
+            return cached;
 
-    Auth::SocketServer::SocketServer()
-            : QLocalServer() {
-        connect(this, &QLocalServer::newConnection, this, &Auth::SocketServer::handleNewConnection);
-    }
-
-    void Auth::SocketServer::handleNewConnection()  {
-        while (hasPendingConnections()) {
-            Msg m = Msg::MSG_UNKNOWN;
-            qint64 id;
-            QLocalSocket *socket = nextPendingConnection();
-            SafeDataStream str(socket);
-            str.receive();
-            str >> m >> id;
-            if (m == Msg::HELLO && id && SocketServer::instance()->helpers.contains(id)) {
-                helpers[id]->setSocket(socket);
-                if (socket->bytesAvailable() > 0)
-                    helpers[id]->dataPending();
-            }
-        }
-    }
-
-    Auth::SocketServer* Auth::SocketServer::instance() {
-        static std::unique_ptr<Auth::SocketServer> self;
-        if (!self) {
-            self.reset(new SocketServer());
-            self->listen(QStringLiteral("sddm-auth%1").arg(QUuid::createUuid().toString().replace(QRegExp(QStringLiteral("[{}]")), QString())));
-        }
-        return self.get();
-    }
-
-
-    Auth::Private::Private(Auth *parent)
-            : QObject(parent)
-            , request(new AuthRequest(parent))
-            , child(new QProcess(this))
-            , id(lastId++) {
-        SocketServer::instance()->helpers[id] = this;
-        QProcessEnvironment env = child->processEnvironment();
-        bool langEmpty = true;
-        QFile localeFile(QStringLiteral("/etc/locale.conf"));
+        QProcessEnvironment env;
+        QFile localeFile(info.filePath());
         if (localeFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
             QTextStream in(&localeFile);
             while (!in.atEnd()) {
                 QStringList parts = in.readLine().split(QLatin1Char('='));
-                if (parts.size() >= 2) {
+                if (parts.size() >= 2)
                     env.insert(parts[0], parts[1]);
-                    if (parts[0] == QLatin1String("LANG"))
-                        langEmpty = false;
-                }
             }
             localeFile.close();
         }
-        if (langEmpty)
+        if (!env.contains(QStringLiteral("LANG")))
             env.insert(QStringLiteral("LANG"), QStringLiteral("C"));
-        child->setProcessEnvironment(env);
-        connect(child, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished), this, &Auth::Private::childExited);
-        connect(child, QOverload<QProcess::ProcessError>::of(&QProcess::error), this, &Auth::Private::childError);
-        connect(request, &AuthRequest::finished, this, &Auth::Private::requestFinished);
-        connect(request, &AuthRequest::promptsChanged, parent, &Auth::requestChanged);
+
+        cached = env;
+        cachedModified = modified;
+        cachedSize = size;
+        return cached;
     }
 
-    Auth::Private::~Private()
-    {
-        SocketServer::instance()->helpers.remove(id);
+
+    HelperConnection::HelperConnection(QLocalSocket *socket, QObject *parent)
+            : QObject(parent)
+            , m_socket(socket) {
+        m_socket->setParent(this);
+        connect(m_socket, &QLocalSocket::readyRead, this, &HelperConnection::readyRead);
+        connect(m_socket, &QLocalSocket::disconnected, this, &QObject::deleteLater);
     }
 
+    void HelperConnection::send(const QByteArray &frame) {
+        // same framing as SafeDataStream, the event loop flushes the socket
+        qint64 length = frame.length();
+        m_socket->write((const char*) &length, sizeof(length));
+        m_socket->write(frame);
+    }
 
-    void Auth::Private::setSocket(QLocalSocket *socket) {
-        this->socket = socket;
-        connect(socket, &QLocalSocket::readyRead, this, &Auth::Private::dataPending);
+    void HelperConnection::readyRead() {
+        m_buffer.append(m_socket->readAll());
+
+        // process every complete frame, keep the rest for the next read
+        while (m_buffer.size() >= int(sizeof(qint64))) {
+            qint64 length = -1;
+            memcpy(&length, m_buffer.constData(), sizeof(length));
+            if (length < 0 || length > std::numeric_limits<int>::max() - int(sizeof(qint64))) {
+                qCritical() << "Auth: Invalid frame length received from helper:" << length;
+                m_socket->abort();
+                return;
+            }
+            if (m_buffer.size() < int(sizeof(qint64) + length))
+                return;
+
+            QByteArray frame = m_buffer.mid(sizeof(qint64), int(length));
+            m_buffer.remove(0, int(sizeof(qint64) + length));
+            process(frame);
+        }
     }
 
-    void Auth::Private::dataPending() {
-        Auth *auth = qobject_cast<Auth*>(parent());
+    void HelperConnection::process(const QByteArray &frame) {
         Msg m = MSG_UNKNOWN;
-        SafeDataStream str(socket);
-        str.receive();
+        QDataStream str(frame);
         str >> m;
+
+        // the first message identifies the helper
+        if (!m_identified) {
+            qint64 id = 0;
+            str >> id;
+            if (m != HELLO || !id) {
+                m_socket->abort();
+                return;
+            }
+            m_identified = true;
+            Q_EMIT hello(id);
+            return;
+        }
+
         switch (m) {
             case ERROR: {
                 QString message;
-                Error type = ERROR_NONE;
+                Auth::Error type = Auth::ERROR_NONE;
                 str >> message >> type;
-                Q_EMIT auth->error(message, type);
+                Q_EMIT error(message, type);
                 break;
             }
             case INFO: {
                 QString message;
-                Info type = INFO_NONE;
+                Auth::Info type = Auth::INFO_NONE;
                 str >> message >> type;
-                Q_EMIT auth->info(message, type);
+                Q_EMIT info(message, type);
                 break;
             }
             case REQUEST: {
                 Request r;
                 str >> r;
-                request->setRequest(&r);
+                Q_EMIT request(r);
                 break;
             }
             case AUTHENTICATED: {
                 QString user;
                 str >> user;
-                if (!user.isEmpty()) {
-                    auth->setUser(user);
-                    Q_EMIT auth->authentication(user, true);
-                    str.reset();
-                    str << AUTHENTICATED << environment << cookie;
-                    str.send();
-                }
-                else {
-                    Q_EMIT auth->authentication(user, false);
-                }
+                Q_EMIT authenticated(user);
                 break;
             }
             case SESSION_STATUS: {
                 bool status;
                 str >> status;
-                Q_EMIT auth->sessionStarted(status);
-                str.reset();
-                str << SESSION_STATUS;
-                str.send();
+                Q_EMIT sessionStatus(status);
                 break;
             }
             default: {
-                Q_EMIT auth->error(QStringLiteral("Auth: Unexpected value received: %1").arg(m), ERROR_INTERNAL);
+                Q_EMIT error(QStringLiteral("Auth: Unexpected value received: %1").arg(m), Auth::ERROR_INTERNAL);
             }
         }
     }
 
+
+    Auth::SocketServer::SocketServer()
+            : QLocalServer() {
+        connect(this, &QLocalServer::newConnection, this, &Auth::SocketServer::handleNewConnection);
+    }
+
+    void Auth::SocketServer::handleNewConnection()  {
+        while (hasPendingConnections()) {
+            HelperConnection *connection = new HelperConnection(nextPendingConnection(), this);
+            connect(connection, &HelperConnection::hello, this, [this, connection] (qint64 id) {
+                attach(connection, id);
+            });
+        }
+    }
+
+    void Auth::SocketServer::attach(HelperConnection *connection, qint64 id) {
+        QMutexLocker locker(&m_mutex);
+        Auth::Private *helper = m_helpers.value(id);
+        if (!helper) {
+            connection->deleteLater();
+            return;
+        }
+        // the connections are queued to the main thread
+        helper->attach(connection);
+        Q_EMIT connection->attached();
+    }
+
+    bool Auth::SocketServer::start(const QString &name) {
+        return listen(name);
+    }
+
+    void Auth::SocketServer::addHelper(qint64 id, Auth::Private *helper) {
+        QMutexLocker locker(&m_mutex);
+        m_helpers[id] = helper;
+    }
+
+    void Auth::SocketServer::removeHelper(qint64 id) {
+        QMutexLocker locker(&m_mutex);
+        m_helpers.remove(id);
+    }
+
+    Auth::SocketServer* Auth::SocketServer::instance() {
+        static SocketServer *self = nullptr;
+        if (!self) {
+            qRegisterMetaType<SDDM::Request>("SDDM::Request");
+
+            QThread *thread = new QThread();
+            thread->setObjectName(QStringLiteral("AuthBroker"));
+
+            self = new SocketServer();
+            self->moveToThread(thread);
+            thread->start();
+
+            // stop the broker before the application goes away, the server
+            // itself is kept since Auth objects may still unregister from it
+            connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, thread, [thread] {
+                thread->quit();
+                thread->wait();
+            }, Qt::DirectConnection);
+
+            const QString name = QStringLiteral("sddm-auth%1").arg(QUuid::createUuid().toString().replace(QRegExp(QStringLiteral("[{}]")), QString()));
+            bool listening = false;
+            QMetaObject::invokeMethod(self, "start", Qt::BlockingQueuedConnection,
+                                      Q_RETURN_ARG(bool, listening), Q_ARG(QString, name));
+            if (!listening)
+                qCritical() << "Auth: Failed to listen for helpers on" << name;
+        }
+        return self;
+    }
+
+
+    Auth::Private::Private(Auth *parent)
+            : QObject(parent)
+            , request(new AuthRequest(parent))
+            , child(new QProcess(this))
+            , id(lastId++) {
+        SocketServer::instance()->addHelper(id, this);
+        child->setProcessEnvironment(localeEnvironment());
+        connect(child, QOverload<int,QProcess::ExitStatus>::of(&QProcess::finished), this, &Auth::Private::childExited);
+        connect(child, QOverload<QProcess::ProcessError>::of(&QProcess::error), this, &Auth::Private::childError);
+        connect(request, &AuthRequest::finished, this, &Auth::Private::requestFinished);
+        connect(request, &AuthRequest::promptsChanged, parent, &Auth::requestChanged);
+    }
+
+    Auth::Private::~Private()
+    {
+        SocketServer::instance()->removeHelper(id);
+    }
+
+
+    void Auth::Private::attach(HelperConnection *connection) {
+        // called on the broker thread, connect() is thread safe
+        connect(connection, &HelperConnection::error, this, &Auth::Private::helperError);
+        connect(connection, &HelperConnection::info, this, &Auth::Private::helperInfo);
+        connect(connection, &HelperConnection::request, this, &Auth::Private::helperRequest);
+        connect(connection, &HelperConnection::authenticated, this, &Auth::Private::helperAuthenticated);
+        connect(connection, &HelperConnection::sessionStatus, this, &Auth::Private::helperSessionStatus);
+        connect(connection, &HelperConnection::attached, this, &Auth::Private::helperConnected);
+        connect(this, &Auth::Private::send, connection, &HelperConnection::send);
+        connect(this, &QObject::destroyed, connection, &QObject::deleteLater);
+    }
+
+    void Auth::Private::helperError(const QString &message, Auth::Error type) {
+        Q_EMIT qobject_cast<Auth*>(parent())->error(message, type);
+    }
+
+    void Auth::Private::helperInfo(const QString &message, Auth::Info type) {
+        Q_EMIT qobject_cast<Auth*>(parent())->info(message, type);
+    }
+
+    void Auth::Private::helperRequest(const SDDM::Request &r) {
+        request->setRequest(&r);
+    }
+
+    void Auth::Private::helperAuthenticated(const QString &user) {
+        Auth *auth = qobject_cast<Auth*>(parent());
+        if (!user.isEmpty()) {
+            auth->setUser(user);
+            Q_EMIT auth->authentication(user, true);
+        }
+        else {
+            Q_EMIT auth->authentication(user, false);
+        }
+    }
+
+    void Auth::Private::helperSessionStatus(bool status) {
+        Q_EMIT qobject_cast<Auth*>(parent())->sessionStarted(status);
+    }
+
+    void Auth::Private::helperConnected() {
+        connected = true;
+
+        // hand out the environment right away, so that the helper
+        // doesn't have to ask for it after authenticating
+        if (environmentDeferred)
+            environmentPending = true;
+        else
+            sendEnvironment();
+    }
+
     void Auth::Private::childExited(int exitCode, QProcess::ExitStatus exitStatus) {
         if (exitStatus != QProcess::NormalExit) {
             qWarning("Auth: sddm-helper crashed (exit code %d)", exitCode);
             Q_EMIT qobject_cast<Auth*>(parent())->error(child->errorString(), ERROR_INTERNAL);
+            Q_EMIT qobject_cast<Auth*>(parent())->finished(Auth::HELPER_CRASHED);
+            return;
         }
 
         if (exitCode == HELPER_SUCCESS)
@@ -224,11 +418,24 @@ namespace SDDM {
         Q_EMIT qobject_cast<Auth*>(parent())->error(child->errorString(), ERROR_INTERNAL);
     }
 
+    void Auth::Private::sendEnvironment() {
+        environmentPending = false;
+        if (environmentSent)
+            return;
+        environmentSent = true;
+
+        QByteArray frame;
+        QDataStream str(&frame, QIODevice::WriteOnly);
+        str << ENVIRONMENT << environment << cookie << sessionPath;
+        Q_EMIT send(frame);
+    }
+
     void Auth::Private::requestFinished() {
-        SafeDataStream str(socket);
+        QByteArray frame;
+        QDataStream str(&frame, QIODevice::WriteOnly);
         Request r = request->request();
         str << REQUEST << r;
-        str.send();
+        Q_EMIT send(frame);
         request->setRequest();
     }
 
@@ -290,6 +497,10 @@ namespace SDDM {
         return d->child->state() != QProcess::NotRunning;
     }
 
+    qint64 Auth::processId() const {
+        return d->child->processId();
+    }
+
     void Auth::insertEnvironment(const QProcessEnvironment &env) {
         d->environment.insert(env);
     }
@@ -334,6 +545,12 @@ namespace SDDM {
         }
     }
 
+    void Auth::setEnvironmentDeferred(bool on) {
+        d->environmentDeferred = on;
+        if (!on && d->environmentPending && d->connected)
+            d->sendEnvironment();
+    }
+
     void Auth::setVerbose(bool on) {
         if (on != verbose()) {
             if (on)
@@ -345,6 +562,11 @@ namespace SDDM {
     }
 
     void Auth::start() {
+        // a new helper needs everything again
+        d->connected = false;
+        d->environmentSent = false;
+        d->environmentPending = false;
+
         QStringList args;
         args << QStringLiteral("--socket") << SocketServer::instance()->fullServerName();
         args << QStringLiteral("--id") << QStringLiteral("%1").arg(d->id);
@@ -358,6 +580,11 @@ namespace SDDM {
             args << QStringLiteral("--greeter");
         d->child->start(QStringLiteral("%1/sddm-helper").arg(QStringLiteral(LIBEXEC_INSTALL_DIR)), args);
     }
+
+    void Auth::stop() {
+        if (isActive())
+            d->child->terminate();
+    }
 }
 
 #include "Auth.moc"
@@ -84,7 +84,9 @@ namespace SDDM {
             HELPER_SUCCESS = 0,
             HELPER_AUTH_ERROR,
             HELPER_SESSION_ERROR,
-            HELPER_OTHER_ERROR
+            HELPER_OTHER_ERROR,
+            // never returned by sddm-helper itself, reported when it crashes
+            HELPER_CRASHED
         };
         Q_ENUM(HelperExitStatus)
 
@@ -101,6 +103,10 @@ namespace SDDM {
          * True if an authentication or session is in progress
          */
         bool isActive() const;
+        /**
+         * Process id of the helper, the session runs below it
+         */
+        qint64 processId() const;
 
         /**
         * If starting a session, you will probably want to provide some basic env variables for the session.
@@ -144,6 +150,7 @@ namespace SDDM {
 
         /**
         * Set the session to be started after authenticating.
+        * May still be changed after start() while the environment is deferred.
         * @param path Path of the session executable to be started
         */
         void setSession(const QString &path);
@@ -154,12 +161,28 @@ namespace SDDM {
          */
         void setCookie(const QString &cookie);
 
+        /**
+         * Hold back the session environment and cookie, which are otherwise
+         * handed to the helper as soon as it connects, until this is turned
+         * off again. Allows starting the helper before the display server
+         * is ready. Changes made after the helper connected without this
+         * set don't reach it.
+         * @param on true if the session should wait
+         */
+        void setEnvironmentDeferred(bool on = true);
+
     public Q_SLOTS:
         /**
         * Sets up the environment and starts the authentication
         */
         void start();
 
+        /**
+        * Terminates the helper, e.g. to abandon an authentication
+        * nobody is going to complete
+        */
+        void stop();
+
     Q_SIGNALS:
         void autologinChanged();
         void greeterChanged();
@@ -22,6 +22,7 @@
 #define MESSAGES_H
 
 #include <QtCore/QDataStream>
+#include <QtCore/QMetaType>
 #include <QtCore/QProcessEnvironment>
 
 #include "Auth.h"
@@ -97,6 +98,7 @@ namespace SDDM {
         REQUEST,
         AUTHENTICATED,
         SESSION_STATUS,
+        ENVIRONMENT,
         MSG_LAST,
     };
 
@@ -151,17 +153,27 @@ namespace SDDM {
         return s;
     }
 
+    // the environment travels as a count followed by key/value pairs,
+    // so neither side has to join or split strings
     inline QDataStream& operator<<(QDataStream &s, const QProcessEnvironment &m) {
-        s << m.toStringList();
+        const QStringList keys = m.keys();
+        s << qint32(keys.size());
+        for (const QString &key : keys)
+            s << key << m.value(key);
         return s;
     }
 
     inline QDataStream& operator>>(QDataStream &s, QProcessEnvironment &m) {
-        QStringList l;
-        s >> l;
-        for (QString s : l) {
-            int pos = s.indexOf(QLatin1Char('='));
-            m.insert(s.left(pos), s.mid(pos + 1));
+        qint32 count = 0;
+        s >> count;
+        if (count < 0) {
+            s.setStatus(QDataStream::ReadCorruptData);
+            return s;
+        }
+        QString key, value;
+        for (qint32 i = 0; i < count && s.status() == QDataStream::Ok; i++) {
+            s >> key >> value;
+            m.insert(key, value);
         }
         return s;
     }
@@ -211,4 +223,6 @@ namespace SDDM {
     }
 }
 
+Q_DECLARE_METATYPE(SDDM::Request)
+
 #endif // MESSAGES_H
@@ -72,20 +72,20 @@ namespace SDDM {
     ConfigSection::ConfigSection(ConfigBase *parent, const QString &name) : m_parent(parent),
         m_name(name) {
         m_parent->m_sections.insert(name, this);
+        m_parent->m_sectionIndex.insert(name, this);
+    }
+
+    void ConfigSection::addEntry(ConfigEntryBase *entry) {
+        m_entries.insert(entry->name(), entry);
+        m_index.insert(entry->name(), entry);
     }
 
     ConfigEntryBase *ConfigSection::entry(const QString &name) {
-        auto it = m_entries.find(name);
-        if (it != m_entries.end())
-            return it.value();
-        return nullptr;
+        return m_index.value(name, nullptr);
     }
 
     const ConfigEntryBase *ConfigSection::entry(const QString &name) const {
-        auto it = m_entries.find(name);
-        if (it != m_entries.end())
-            return it.value();
-        return nullptr;
+        return m_index.value(name, nullptr);
     }
 
     const QMap<QString, ConfigEntryBase*> &ConfigSection::entries() const {
@@ -181,6 +181,7 @@ namespace SDDM {
             return;
         }
         m_fileModificationTime = latestModificationTime;
+        m_generation++;
 
         for (const QString &filepath : qAsConst(files)) {
             loadInternal(filepath);
@@ -188,41 +189,63 @@ namespace SDDM {
     }
 
 
+    ConfigSection *ConfigBase::findSection(const QString &name) const {
+        // sections renamed in version 0.14.0
+        static const QHash<QString, QString> aliases {
+            { QStringLiteral("XDisplay"), QStringLiteral("X11") },
+            { QStringLiteral("WaylandDisplay"), QStringLiteral("Wayland") },
+        };
+
+        ConfigSection *section = m_sectionIndex.value(name, nullptr);
+        if (!section) {
+            auto alias = aliases.constFind(name);
+            if (alias != aliases.constEnd())
+                section = m_sectionIndex.value(alias.value(), nullptr);
+        }
+        return section;
+    }
+
     void ConfigBase::loadInternal(const QString &filepath) {
-        QString currentSection = QStringLiteral(IMPLICIT_SECTION);
+        // resolved once per section header instead of once per line
+        QString currentName = QStringLiteral(IMPLICIT_SECTION);
+        ConfigSection *currentSection = findSection(currentName);
 
         QFile in(filepath);
 
         if (!in.open(QIODevice::ReadOnly))
             return;
+        int lineNumber = 0;
         while (!in.atEnd()) {
+            ++lineNumber;
             QString line = QString::fromUtf8(in.readLine());
             QStringRef lineRef = QStringRef(&line).trimmed();
             // get rid of comments first
             lineRef = lineRef.left(lineRef.indexOf(QLatin1Char('#'))).trimmed();
 
-            // In version 0.14.0, these sections were renamed
-            if (currentSection == QStringLiteral("XDisplay"))
-                currentSection = QStringLiteral("X11");
-            else if (currentSection == QStringLiteral("WaylandDisplay"))
-                currentSection = QStringLiteral("Wayland");
-
             // value assignment
             int separatorPosition = lineRef.indexOf(QLatin1Char('='));
             if (separatorPosition >= 0) {
                 QString name = lineRef.left(separatorPosition).trimmed().toString();
                 QStringRef value = lineRef.mid(separatorPosition + 1).trimmed();
 
-                auto sectionIterator = m_sections.constFind(currentSection);
-                if (sectionIterator != m_sections.constEnd() && sectionIterator.value()->entry(name))
-                    sectionIterator.value()->entry(name)->setValue(value.toString());
-                else
+                ConfigEntryBase *entry = currentSection ? currentSection->entry(name) : nullptr;
+                if (entry) {
+                    entry->setValue(value.toString());
+                } else {
                     // if we don't have such member in the config, nag about it
                     m_unusedVariables = true;
+                    if (currentSection)
+                        qWarning("%s:%d: unknown key \"%s\" in section [%s]", qPrintable(filepath), lineNumber,
+                                 qPrintable(name), qPrintable(currentName));
+                }
             }
             // section start
-            else if (lineRef.startsWith(QLatin1Char('[')) && lineRef.endsWith(QLatin1Char(']')))
-                currentSection = lineRef.mid(1, lineRef.length() - 2).toString();
+            else if (lineRef.startsWith(QLatin1Char('[')) && lineRef.endsWith(QLatin1Char(']'))) {
+                currentName = lineRef.mid(1, lineRef.length() - 2).toString();
+                currentSection = findSection(currentName);
+                if (!currentSection)
+                    qWarning("%s:%d: unknown section [%s]", qPrintable(filepath), lineNumber, qPrintable(currentName));
+            }
         }
     }
 
@@ -367,5 +390,10 @@ namespace SDDM {
         for (auto it : m_sections) {
             it->clear();
         }
+        m_generation++;
+    }
+
+    uint ConfigBase::generation() const {
+        return m_generation;
     }
 }
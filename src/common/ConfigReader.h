@@ -27,6 +27,7 @@
 #include <QtCore/QDebug>
 #include <QtCore/QDateTime>
 #include <QtCore/QDir>
+#include <QtCore/QHash>
 
 #define IMPLICIT_SECTION "General"
 #define UNUSED_VARIABLE_COMMENT "# Unused variable"
@@ -95,8 +96,12 @@ namespace SDDM {
         QString toConfigFull() const;
         const QMap<QString, ConfigEntryBase*> &entries() const;
     private:
+        void addEntry(ConfigEntryBase *entry);
+
         template<class T> friend class ConfigEntryPrivate;
+        // ordered for writing, hashed for lookups while parsing
         QMap<QString, ConfigEntryBase*> m_entries {};
+        QHash<QString, ConfigEntryBase*> m_index {};
 
         ConfigBase *m_parent { nullptr };
         QString m_name { };
@@ -113,7 +118,7 @@ namespace SDDM {
             m_value(value),
             m_isDefault(true),
             m_parent(parent) {
-            m_parent->m_entries[name] = this;
+            m_parent->addEntry(this);
         }
 
         T get() const {
@@ -193,6 +198,8 @@ namespace SDDM {
         void wipe();
         bool hasUnused() const;
         QString toConfigFull() const;
+        // bumped whenever the values were reloaded or wiped
+        uint generation() const;
     protected:
         bool m_unusedVariables { false };
         bool m_unusedSections { false };
@@ -203,9 +210,12 @@ namespace SDDM {
         QMap<QString, ConfigSection*> m_sections;
         friend class ConfigSection;
     private:
+        ConfigSection *findSection(const QString &name) const;
         QDateTime dirLatestModifiedTime(const QString &directory);
         void loadInternal(const QString &filepath);
         QDateTime m_fileModificationTime;
+        uint m_generation { 0 };
+        QHash<QString, ConfigSection*> m_sectionIndex;
     };
 }
 
@@ -44,6 +44,9 @@ namespace SDDM {
                                                                                                    "NOTE: Currently ignored if autologin is enabled."));
         Entry(InputMethod,         QString,     QStringLiteral("qtvirtualkeyboard"),                   _S("Input method module"));
         Entry(Namespaces,          QStringList, QStringList(),                                  _S("Comma-separated list of Linux namespaces for user session to enter"));
+        Entry(PersistentGreeter,   bool,        false,                                      _S("Keep the greeter running hidden after logging into a session\n"
+                                                                                                   "that does not use the greeter display, and show it again\n"
+                                                                                                   "when that session ends instead of starting a new one"));
         //  Name   Entries (but it's a regular class again)
         Section(Theme,
             Entry(ThemeDir,            QString,     _S(DATA_INSTALL_DIR "/themes"),             _S("Theme directory path"));
@@ -56,6 +59,8 @@ namespace SDDM {
             Entry(DisableAvatarsThreshold,int,      7,                                          _S("Number of users to use as threshold\n"
                                                                                                    "above which avatars are disabled\n"
                                                                                                    "unless explicitly enabled with EnableAvatars"));
+            Entry(WarmCaches,          bool,        true,                                       _S("Keep the font cache and the icon cache of the theme's icon theme\n"
+                                                                                                   "up to date in the background"));
         );
 
         // TODO: Not absolutely sure if everything belongs here. Xsessions, VT and probably some more seem universal
@@ -92,6 +97,30 @@ namespace SDDM {
             Entry(RememberLastSession, bool,        true,                                       _S("Remember the session of the last successfully logged in user"));
 
             Entry(ReuseSession,        bool,        true,                                       _S("When logging in as the same user twice, restore the original session, rather than create a new one"));
+            Entry(CacheLoginEnvironment, bool,      false,                                      _S("Reuse the environment captured from csh and fish login shells\n"
+                                                                                                   "until one of their profile files changes"));
+            Entry(LoginRetryDelay,     int,         1,                                          _S("Seconds a user has to wait after the third failed login in a row,\n"
+                                                                                                   "doubled with every further failure. The whole seat is throttled\n"
+                                                                                                   "the same way after ten failures. 0 disables the delay"));
+            Entry(LoginRetryMaxDelay,  int,         60,                                         _S("Upper limit of the delay between failed logins, in seconds"));
+        );
+
+        Section(Resources,
+            Entry(CgroupPath,          QString,     QString(),                                  _S("cgroup v2 directory below which a group is created for each seat,\n"
+                                                                                                   "e.g. a directory delegated to sddm. Display servers and display\n"
+                                                                                                   "scripts of a seat are moved into its group.\n"
+                                                                                                   "Empty disables the per seat groups"));
+            Entry(CpuWeight,           int,         0,                                          _S("CPU weight of each seat group (1-10000), 0 keeps the default"));
+            Entry(IoWeight,            int,         0,                                          _S("I/O weight of each seat group (1-10000), 0 keeps the default"));
+            Entry(MemoryMax,           QString,     QString(),                                  _S("Memory ceiling of each seat group, e.g. 512M. Empty means no limit"));
+            Entry(CpuAffinity,         QStringList, QStringList(),                              _S("Comma-separated list of seat:cpus pairs restricting seats to\n"
+                                                                                                   "certain CPUs, e.g. seat0:0-3,seat1:4-7"));
+        );
+
+        Section(Readahead,
+            Entry(Enabled,             bool,        false,                                      _S("Record the files a session opens while starting up and read them\n"
+                                                                                                   "into the page cache on later logins while the greeter is shown"));
+            Entry(RecordTime,          int,         30,                                         _S("Seconds of session startup that are recorded"));
         );
 
         Section(Autologin,
@@ -0,0 +1,56 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+
+#include "GreeterSnapshot.h"
+
+#include "Constants.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+
+namespace SDDM {
+    namespace GreeterSnapshot {
+        QString directory(const QString &themePath, int rootWidth, int rootHeight) {
+            // the embedded theme is versioned with the greeter binary
+            QFileInfoList files;
+            if (themePath.isEmpty())
+                files << QFileInfo(QStringLiteral(BIN_INSTALL_DIR "/sddm-greeter"));
+            else
+                files = QDir(themePath).entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+
+            QCryptographicHash hash(QCryptographicHash::Md5);
+            hash.addData(themePath.toUtf8());
+            for (const QFileInfo &file : qAsConst(files)) {
+                hash.addData(file.fileName().toUtf8());
+                hash.addData(QByteArray::number(file.lastModified().toMSecsSinceEpoch()));
+            }
+
+            return QStringLiteral(STATE_DIR "/snapshots/%1/%2x%3")
+                    .arg(QString::fromLatin1(hash.result().toHex()))
+                    .arg(rootWidth).arg(rootHeight);
+        }
+
+        QString fileName(int x, int y) {
+            return QStringLiteral("%1_%2.raw").arg(x).arg(y);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+
+#ifndef SDDM_GREETERSNAPSHOT_H
+#define SDDM_GREETERSNAPSHOT_H
+
+#include <QtCore/QString>
+
+namespace SDDM {
+    /**
+     * Snapshots of the first frame the greeter rendered on each screen.
+     * The daemon paints them on the root window before the greeter is
+     * started, so the screen does not stay black while QML loads.
+     *
+     * Each file holds a Header followed by width * height pixels in
+     * native endian 0xffRRGGBB format and is named after the position
+     * of the screen, in device pixels, within the root window.
+     */
+    namespace GreeterSnapshot {
+        struct Header {
+            quint32 magic;
+            quint32 width;
+            quint32 height;
+        };
+
+        static const quint32 Magic = 0x53444d31; // "SDM1"
+
+        // directory holding the snapshots of a theme for a root window size,
+        // it changes whenever a file of the theme is modified
+        QString directory(const QString &themePath, int rootWidth, int rootHeight);
+
+        QString fileName(int x, int y);
+    }
+}
+
+#endif // SDDM_GREETERSNAPSHOT_H
@@ -30,14 +30,18 @@ namespace SDDM {
         Reboot,
         Suspend,
         Hibernate,
-        HybridSleep
+        HybridSleep,
+        SelectUser
     };
 
     enum class DaemonMessages {
         HostName,
         Capabilities,
         LoginSucceeded,
-        LoginFailed
+        LoginFailed,
+        PowerActionFinished,
+        StayResident,
+        Reset
     };
 
     enum Capability {
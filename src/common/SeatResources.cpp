@@ -0,0 +1,125 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+#include "SeatResources.h"
+
+#include "Configuration.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace SDDM {
+    namespace SeatResources {
+        // cgroup files take a single write(2) each
+        static bool writeFile(const QByteArray &path, const QByteArray &value) {
+            int fd = ::open(path.constData(), O_WRONLY | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+            bool ok = ::write(fd, value.constData(), value.size()) == value.size();
+            ::close(fd);
+            return ok;
+        }
+
+        static QString groupPath(const QString &seat) {
+            return QStringLiteral("%1/%2").arg(mainConfig.Resources.CgroupPath.get(), seat);
+        }
+
+        static QString cpusOf(const QString &seat) {
+            // entries look like seat0:0-3
+            const QString prefix = seat + QLatin1Char(':');
+            for (const QString &entry : mainConfig.Resources.CpuAffinity.get()) {
+                if (entry.startsWith(prefix))
+                    return entry.mid(prefix.length());
+            }
+            return QString();
+        }
+
+        bool isEnabled() {
+#ifdef Q_OS_LINUX
+            return !mainConfig.Resources.CgroupPath.get().isEmpty();
+#else
+            return false;
+#endif
+        }
+
+        bool prepare(const QString &seat) {
+            if (!isEnabled())
+                return false;
+
+            const QString base = mainConfig.Resources.CgroupPath.get();
+            const QString group = groupPath(seat);
+            if (!QDir().mkpath(group)) {
+                qWarning() << "Failed to create the control group" << group;
+                return false;
+            }
+
+            // the limits only work with the controllers enabled for the children,
+            // some may be missing, so try them one by one
+            for (const char *controller : { "+cpu", "+memory", "+io", "+cpuset" })
+                writeFile(QFile::encodeName(base + QStringLiteral("/cgroup.subtree_control")), controller);
+
+            auto apply = [&group](const char *file, const QString &value) {
+                if (value.isEmpty())
+                    return;
+                const QString path = QStringLiteral("%1/%2").arg(group, QLatin1String(file));
+                if (!writeFile(QFile::encodeName(path), value.toLatin1()))
+                    qWarning() << "Failed to set" << path << "to" << value << ":" << strerror(errno);
+            };
+
+            const int cpuWeight = mainConfig.Resources.CpuWeight.get();
+            const int ioWeight = mainConfig.Resources.IoWeight.get();
+            apply("cpu.weight", cpuWeight > 0 ? QString::number(cpuWeight) : QString());
+            apply("io.weight", ioWeight > 0 ? QString::number(ioWeight) : QString());
+            apply("memory.max", mainConfig.Resources.MemoryMax.get());
+            apply("cpuset.cpus", cpusOf(seat));
+
+            return true;
+        }
+
+        bool attach(const QString &seat, qint64 pid) {
+            if (!isEnabled() || seat.isEmpty() || pid <= 0)
+                return false;
+
+            const QByteArray procs = QFile::encodeName(groupPath(seat) + QStringLiteral("/cgroup.procs"));
+            if (!writeFile(procs, QByteArray::number(pid))) {
+                qWarning("Failed to move process %lld into %s: %s", pid, procs.constData(), strerror(errno));
+                return false;
+            }
+            return true;
+        }
+
+        bool release(const QString &seat) {
+            if (!isEnabled() || seat.isEmpty())
+                return true;
+
+            const QByteArray group = QFile::encodeName(groupPath(seat));
+            if (::rmdir(group.constData()) == 0 || errno == ENOENT)
+                return true;
+            if (errno != EBUSY)
+                qWarning("Failed to remove the control group %s: %s", group.constData(), strerror(errno));
+            return false;
+        }
+    }
+}
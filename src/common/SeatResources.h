@@ -0,0 +1,47 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+#ifndef SDDM_SEATRESOURCES_H
+#define SDDM_SEATRESOURCES_H
+
+#include <QtCore/QString>
+
+namespace SDDM {
+    /**
+     * Per seat control groups below the configured cgroup v2 directory.
+     * Display servers and display scripts of a seat are moved there so
+     * that a busy seat can't starve the others. Greeters and user sessions
+     * stay in the scopes logind creates for them.
+     */
+    namespace SeatResources {
+        // true when [Resources] CgroupPath is set
+        bool isEnabled();
+
+        // creates the group of the seat and applies the configured limits
+        bool prepare(const QString &seat);
+
+        // moves a process into the group of the seat
+        bool attach(const QString &seat, qint64 pid);
+
+        // removes the group of the seat, fails while processes are left in it
+        bool release(const QString &seat);
+    }
+}
+
+#endif // SDDM_SEATRESOURCES_H
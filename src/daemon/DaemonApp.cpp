@@ -22,6 +22,9 @@
 #include "Configuration.h"
 #include "Constants.h"
 #include "DisplayManager.h"
+#include "GreeterCache.h"
+#include "Metrics.h"
+#include "SessionReadahead.h"
 #include "PowerManager.h"
 #include "SeatManager.h"
 #include "SignalHandler.h"
@@ -41,6 +44,8 @@ namespace SDDM {
         // point instance to this
         self = this;
 
+        m_uptime.start();
+
         qInstallMessageHandler(SDDM::DaemonMessageHandler);
 
         // log message
@@ -49,12 +54,21 @@ namespace SDDM {
         // set testing parameter
         m_testing = (arguments().indexOf(QStringLiteral("--test-mode")) != -1);
 
+        // create metrics, the display manager exports them
+        m_metrics = new Metrics(this);
+
         // create display manager
         m_displayManager = new DisplayManager(this);
 
         // create power manager
         m_powerManager = new PowerManager(this);
 
+        // create session readahead
+        m_readahead = new SessionReadahead(this);
+
+        // keep the greeter caches warm
+        m_greeterCache = new GreeterCache(this);
+
         // create seat manager
         m_seatManager = new SeatManager(this);
 
@@ -87,14 +101,26 @@ namespace SDDM {
         return QHostInfo::localHostName();
     }
 
+    qint64 DaemonApp::uptime() const {
+        return m_uptime.elapsed();
+    }
+
     DisplayManager *DaemonApp::displayManager() const {
         return m_displayManager;
     }
 
+    Metrics *DaemonApp::metrics() const {
+        return m_metrics;
+    }
+
     PowerManager *DaemonApp::powerManager() const {
         return m_powerManager;
     }
 
+    SessionReadahead *DaemonApp::readahead() const {
+        return m_readahead;
+    }
+
     SeatManager *DaemonApp::seatManager() const {
         return m_seatManager;
     }
@@ -21,14 +21,18 @@
 #define SDDM_DAEMONAPP_H
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 
 #define daemonApp DaemonApp::instance()
 
 namespace SDDM {
     class Configuration;
     class DisplayManager;
+    class Metrics;
     class PowerManager;
     class SeatManager;
+    class SessionReadahead;
+    class GreeterCache;
     class SignalHandler;
 
     class DaemonApp : public QCoreApplication {
@@ -44,9 +48,12 @@ namespace SDDM {
         bool first { true };
 
         QString hostName() const;
+        qint64 uptime() const;
         DisplayManager *displayManager() const;
+        Metrics *metrics() const;
         PowerManager *powerManager() const;
         SeatManager *seatManager() const;
+        SessionReadahead *readahead() const;
         SignalHandler *signalHandler() const;
 
     public slots:
@@ -58,9 +65,13 @@ namespace SDDM {
         int m_lastSessionId { 0 };
 
         bool m_testing { false };
+        QElapsedTimer m_uptime;
         DisplayManager *m_displayManager { nullptr };
+        Metrics *m_metrics { nullptr };
         PowerManager *m_powerManager { nullptr };
         SeatManager *m_seatManager { nullptr };
+        SessionReadahead *m_readahead { nullptr };
+        GreeterCache *m_greeterCache { nullptr };
         SignalHandler *m_signalHandler { nullptr };
     };
 }
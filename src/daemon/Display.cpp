@@ -24,12 +24,15 @@
 #include "Configuration.h"
 #include "DaemonApp.h"
 #include "DisplayManager.h"
+#include "Metrics.h"
 #include "XorgDisplayServer.h"
 #include "Seat.h"
+#include "SessionReadahead.h"
 #include "SocketServer.h"
 #include "Greeter.h"
 #include "Utils.h"
 #include "SignalHandler.h"
+#include "VirtualTerminal.h"
 
 #include <QDebug>
 #include <QFile>
@@ -48,13 +51,38 @@
 
 
 namespace SDDM {
+    // minimum time between two helpers spawned for a selected user
+    static const int s_preselectInterval = 1000;
+
     Display::Display(const int terminalId, Seat *parent) : QObject(parent),
         m_terminalId(terminalId),
-        m_auth(new Auth(this)),
         m_displayServer(new XorgDisplayServer(this)),
-        m_seat(parent),
-        m_socketServer(new SocketServer(this)),
-        m_greeter(new Greeter(this)) {
+        m_seat(parent) {
+
+        // restart display after display server ended
+        connect(m_displayServer, &DisplayServer::started, this, &Display::displayServerStarted);
+        connect(m_displayServer, &DisplayServer::stopped, this, &Display::stop);
+
+        // prepare the last user name that came in while rate limited
+        m_preselectTimer.setSingleShot(true);
+        m_preselectTimer.setInterval(s_preselectInterval);
+        connect(&m_preselectTimer, &QTimer::timeout, this, [this]() {
+            const QString user = m_preselectUser;
+            m_preselectUser.clear();
+            if (!user.isEmpty())
+                preselectUser(user);
+        });
+    }
+
+    Display::~Display() {
+        stop();
+    }
+
+    Auth *Display::createAuth() {
+        if (m_auth)
+            return m_auth;
+
+        m_auth = new Auth(this);
 
         // respond to authentication requests
         m_auth->setVerbose(true);
@@ -65,20 +93,82 @@ namespace SDDM {
         connect(m_auth, &Auth::info, this, &Display::slotAuthInfo);
         connect(m_auth, &Auth::error, this, &Display::slotAuthError);
 
-        // restart display after display server ended
-        connect(m_displayServer, &DisplayServer::started, this, &Display::displayServerStarted);
-        connect(m_displayServer, &DisplayServer::stopped, this, &Display::stop);
+        return m_auth;
+    }
+
+    void Display::releaseGreeter() {
+        // wait until the greeter has gone away by itself
+        if (m_greeter && m_greeter->isRunning())
+            return;
 
-        // connect login signal
-        connect(m_socketServer, &SocketServer::login, this, &Display::login);
+        if (m_greeter) {
+            m_greeter->deleteLater();
+            m_greeter = nullptr;
+        }
 
-        // connect login result signals
-        connect(this, SIGNAL(loginFailed(QLocalSocket*)), m_socketServer, SLOT(loginFailed(QLocalSocket*)));
-        connect(this, SIGNAL(loginSucceeded(QLocalSocket*)), m_socketServer, SLOT(loginSucceeded(QLocalSocket*)));
+        if (m_socketServer) {
+            m_socketServer->stop();
+            m_socketServer->deleteLater();
+            m_socketServer = nullptr;
+        }
+
+        logMemoryUsage(QStringLiteral("greeter released"));
     }
 
-    Display::~Display() {
-        stop();
+    void Display::slotGreeterStopped() {
+        // a resident greeter that went away can't be shown again
+        m_greeterResident = false;
+
+        // the greeter phase is over once the user session runs
+        if (m_sessionStarted)
+            releaseGreeter();
+    }
+
+    bool Display::canKeepGreeter() const {
+        // an X11 session runs on the greeter display and takes it down
+        // when it ends, a reused session makes the helper exit right away
+        return mainConfig.PersistentGreeter.get() &&
+               m_greeter && m_greeter->isRunning() &&
+               m_lastSession.xdgSessionType() != QLatin1String("x11") &&
+               m_reuseSessionId.isNull();
+    }
+
+    void Display::showResidentGreeter() {
+        qDebug() << "Session finished, showing the resident greeter again";
+
+        m_greeterResident = false;
+        m_sessionStarted = false;
+
+        // the next login gets a fresh helper
+        m_auth->deleteLater();
+        m_auth = nullptr;
+
+        // the session had its own terminal, come back to the greeter one
+        if (m_terminalId != -1)
+            VirtualTerminal::jumpToVt(m_terminalId, false);
+
+        m_socketServer->reset();
+
+        daemonApp->metrics()->setSeatState(m_seat->name(), QStringLiteral("greeter"));
+        logMemoryUsage(QStringLiteral("greeter shown again"));
+    }
+
+    void Display::logMemoryUsage(const QString &phase) const {
+        QStringList alive;
+        if (m_auth)
+            alive << QStringLiteral("auth");
+        if (m_socketServer)
+            alive << QStringLiteral("socket server");
+        if (m_greeter)
+            alive << QStringLiteral("greeter");
+
+        const qint64 rss = residentSetSize();
+        qDebug().noquote() << QStringLiteral("Display %1 %2: daemon RSS %3 kB (%4%5 kB since display start), alive: %6")
+                              .arg(name(), phase)
+                              .arg(rss / 1024)
+                              .arg(rss >= m_startRss ? QStringLiteral("+") : QString())
+                              .arg((rss - m_startRss) / 1024)
+                              .arg(alive.isEmpty() ? QStringLiteral("none") : alive.join(QStringLiteral(", ")));
     }
 
     QString Display::displayId() const {
@@ -101,8 +191,33 @@ namespace SDDM {
         return m_seat;
     }
 
+    bool Display::isShowingGreeter() const {
+        return m_started && m_greeter && !m_sessionStarted;
+    }
+
+    bool Display::loggedInFromGreeter() const {
+        return m_loggedInFromGreeter;
+    }
+
     bool Display::start() {
-        return m_started || m_displayServer->start();
+        if (m_started)
+            return true;
+
+        m_startRss = residentSetSize();
+
+        // Autologin doesn't need a greeter, start authenticating right away
+        // so that the helper and PAM run while the display server comes up.
+        // The session waits for the display in displayServerStarted().
+        // a seat stuck in a crash loop needs a human, never autologin there
+        if ((daemonApp->first || mainConfig.Autologin.Relogin.get()) &&
+            !mainConfig.Autologin.User.get().isEmpty() && !m_seat->isCrashLooping()) {
+            createAuth()->setEnvironmentDeferred(true);
+            m_autologin = attemptAutologin();
+            if (!m_autologin)
+                m_auth->setEnvironmentDeferred(false);
+        }
+
+        return m_displayServer->start();
     }
 
     bool Display::attemptAutologin() {
@@ -126,7 +241,11 @@ namespace SDDM {
         Session session;
         session.setTo(sessionType, autologinSession);
 
-        m_auth->setAutologin(true);
+        // runs alongside the display server start
+        daemonApp->readahead()->prefetch(session.fileName());
+
+        createAuth()->setAutologin(true);
+        m_loginTimer.start();
         startAuth(mainConfig.Autologin.User.get(), QString(), session);
 
         return true;
@@ -143,18 +262,45 @@ namespace SDDM {
         // log message
         qDebug() << "Display server started.";
 
-        if ((daemonApp->first || mainConfig.Autologin.Relogin.get()) &&
-            !mainConfig.Autologin.User.get().isEmpty()) {
+        // a failed early autologin has dropped its authenticator, show the greeter instead
+        if (m_autologin && m_auth) {
             // reset first flag
             daemonApp->first = false;
 
             // set flags
             m_started = true;
 
-            bool success = attemptAutologin();
-            if (success) {
-                return;
-            }
+            // the display is known now, let the session continue
+            if (m_lastSession.xdgSessionType() == QLatin1String("x11"))
+                m_auth->insertEnvironment(QStringLiteral("DISPLAY"), name());
+            m_auth->setCookie(qobject_cast<XorgDisplayServer *>(m_displayServer)->cookie());
+            m_auth->setEnvironmentDeferred(false);
+
+            daemonApp->metrics()->setSeatState(m_seat->name(), QStringLiteral("autologin"));
+            return;
+        }
+        m_autologin = false;
+
+        startGreeter();
+    }
+
+    void Display::startGreeter() {
+        // create socket server and greeter, they are not needed for autologin
+        if (!m_socketServer) {
+            m_socketServer = new SocketServer(this);
+
+            // connect login signal
+            connect(m_socketServer, &SocketServer::login, this, &Display::login);
+            connect(m_socketServer, &SocketServer::userSelected, this, &Display::preselectUser);
+
+            // connect login result signals
+            connect(this, SIGNAL(loginFailed(QLocalSocket*)), m_socketServer, SLOT(loginFailed(QLocalSocket*)));
+            connect(this, SIGNAL(loginSucceeded(QLocalSocket*)), m_socketServer, SLOT(loginSucceeded(QLocalSocket*)));
+            connect(this, SIGNAL(stayResident(QLocalSocket*)), m_socketServer, SLOT(stayResident(QLocalSocket*)));
+        }
+        if (!m_greeter) {
+            m_greeter = new Greeter(this);
+            connect(m_greeter, &Greeter::stopped, this, &Display::slotGreeterStopped);
         }
 
         // start socket server
@@ -177,8 +323,15 @@ namespace SDDM {
         m_greeter->setSocket(m_socketServer->socketAddress());
         m_greeter->setTheme(findGreeterTheme());
 
+        // show the last frame of the greeter while it loads
+        qobject_cast<XorgDisplayServer *>(m_displayServer)->showSnapshot(findGreeterTheme());
+
         // start greeter
         m_greeter->start();
+        daemonApp->metrics()->setSeatState(m_seat->name(), QStringLiteral("greeter"));
+
+        // the last session is the likely one, warm the cache while the user types
+        daemonApp->readahead()->prefetch(stateConfig.Last.Session.get());
 
         // reset first flag
         daemonApp->first = false;
@@ -193,10 +346,12 @@ namespace SDDM {
             return;
 
         // stop the greeter
-        m_greeter->stop();
+        if (m_greeter)
+            m_greeter->stop();
 
         // stop socket server
-        m_socketServer->stop();
+        if (m_socketServer)
+            m_socketServer->stop();
 
         // stop display server
         m_displayServer->blockSignals(true);
@@ -205,6 +360,12 @@ namespace SDDM {
 
         // reset flag
         m_started = false;
+        m_sessionStarted = false;
+        m_greeterResident = false;
+
+        logMemoryUsage(QStringLiteral("stopped"));
+
+        daemonApp->metrics()->setSeatState(m_seat->name(), QStringLiteral("stopped"));
 
         // emit signal
         emit stopped();
@@ -213,19 +374,91 @@ namespace SDDM {
     void Display::login(QLocalSocket *socket,
                         const QString &user, const QString &password,
                         const Session &session) {
-        m_socket = socket;
-
         //the SDDM user has special privileges that skip password checking so that we can load the greeter
         //block ever trying to log in as the SDDM user
         if (user == QLatin1String("sddm")) {
+            m_socket = socket;
+            return;
+        }
+
+        // a deferred user selection must not replace this login
+        m_preselectUser.clear();
+
+        // reject retries that come too fast before spawning a helper
+        const qint64 wait = m_seat->loginLimiter()->delay(user);
+        if (wait > 0) {
+            qWarning() << "Too many failed logins, rejecting attempt for" << user << "for another" << wait << "ms";
+            daemonApp->metrics()->increment(Metrics::AuthThrottled);
+            emit loginFailed(socket);
             return;
         }
 
+        m_socket = socket;
+
+        // in case another session than the last one was chosen
+        daemonApp->readahead()->prefetch(session.fileName());
+
         // authenticate
+        m_loginTimer.start();
         startAuth(user, password, session);
     }
 
+    void Display::preselectUser(const QString &user) {
+        // only prepare logins, never interfere with a running one
+        if (m_sessionStarted || user.isEmpty() || user == QLatin1String("sddm"))
+            return;
+        if (m_auth && m_auth->isActive() && (m_preStartedUser.isEmpty() || m_preStartedUser == user))
+            return;
+
+        // a typed user name may not be complete yet
+        if (!getpwnam(qPrintable(user)))
+            return;
+
+        // throttled users get no helper until they may try again
+        if (m_seat->loginLimiter()->delay(user) > 0)
+            return;
+
+        // greeters decide when to send user names, spawn at most one helper a second
+        if (m_preselectTimer.isActive()) {
+            m_preselectUser = user;
+            return;
+        }
+        m_preselectTimer.start();
+
+        if (m_auth && m_auth->isActive())
+            abandonPreStart();
+
+        qDebug() << "Preparing authentication for" << user;
+
+        // spawn the helper and let PAM run until it asks for the password,
+        // nothing may reach the session before the greeter actually logs in
+        m_preStartedUser = user;
+        m_preAuthenticated = false;
+        createAuth();
+        m_auth->setEnvironmentDeferred(true);
+        m_auth->setUser(user);
+        m_auth->start();
+    }
+
+    void Display::abandonPreStart() {
+        qDebug() << "Abandoning the authentication prepared for" << m_preStartedUser;
+
+        m_preStartedUser.clear();
+        m_preAuthenticated = false;
+
+        // let the helper go away quietly
+        Auth *auth = m_auth;
+        m_auth = nullptr;
+        auth->disconnect(this);
+        connect(auth, &Auth::finished, auth, &QObject::deleteLater);
+        auth->stop();
+    }
+
     QString Display::findGreeterTheme() const {
+        // the configured theme may be what keeps crashing
+        if (m_seat->isCrashLooping())
+            return QString();
+
         QString themeName = mainConfig.Theme.Current.get();
 
         // an unconfigured theme means the user wants to load the
@@ -257,11 +490,21 @@ namespace SDDM {
 
     void Display::startAuth(const QString &user, const QString &password, const Session &session) {
 
-        if (m_auth->isActive()) {
-            qWarning() << "Existing authentication ongoing, aborting";
-            return;
+        // the helper may already be waiting for this user's password
+        bool preStarted = false;
+        if (m_auth && m_auth->isActive()) {
+            if (!m_preStartedUser.isEmpty() && m_preStartedUser == user) {
+                preStarted = true;
+            } else if (!m_preStartedUser.isEmpty()) {
+                abandonPreStart();
+            } else {
+                qWarning() << "Existing authentication ongoing, aborting";
+                return;
+            }
         }
 
+        createAuth();
+
         m_passPhrase = password;
 
         // sanity check
@@ -307,44 +550,64 @@ namespace SDDM {
         // some information
         qDebug() << "Session" << m_sessionName << "selected, command:" << session.exec();
 
-        QProcessEnvironment env;
+        QProcessEnvironment env = seat()->environment()->session();
 
         if (seat()->name() == QLatin1String("seat0")) {
             // Use the greeter VT, for wayland sessions the helper overwrites this
             env.insert(QStringLiteral("XDG_VTNR"), QString::number(terminalId()));
         }
 
-        env.insert(QStringLiteral("PATH"), mainConfig.Users.DefaultPath.get());
         if (session.xdgSessionType() == QLatin1String("x11"))
             env.insert(QStringLiteral("DISPLAY"), name());
-        env.insert(QStringLiteral("XDG_SEAT_PATH"), daemonApp->displayManager()->seatPath(seat()->name()));
         env.insert(QStringLiteral("XDG_SESSION_PATH"), daemonApp->displayManager()->sessionPath(QStringLiteral("Session%1").arg(daemonApp->newSessionId())));
         env.insert(QStringLiteral("DESKTOP_SESSION"), session.desktopSession());
         env.insert(QStringLiteral("XDG_CURRENT_DESKTOP"), session.desktopNames());
-        env.insert(QStringLiteral("XDG_SESSION_CLASS"), QStringLiteral("user"));
         env.insert(QStringLiteral("XDG_SESSION_TYPE"), session.xdgSessionType());
-        env.insert(QStringLiteral("XDG_SEAT"), seat()->name());
         env.insert(QStringLiteral("XDG_SESSION_DESKTOP"), session.desktopNames());
 
         m_auth->insertEnvironment(env);
 
+        // the helper gets session, environment and cookie before it even
+        // authenticates, it doesn't have to ask for them afterwards
         m_auth->setUser(user);
         if (m_reuseSessionId.isNull()) {
             m_auth->setSession(session.exec());
+            m_auth->setCookie(qobject_cast<XorgDisplayServer *>(m_displayServer)->cookie());
         }
-        m_auth->start();
+
+        if (!preStarted) {
+            m_auth->start();
+            return;
+        }
+
+        qDebug() << "Continuing the authentication prepared for" << user;
+        m_preStartedUser.clear();
+        if (m_preAuthenticated) {
+            // PAM let the user in without asking anything
+            m_preAuthenticated = false;
+            slotAuthenticationFinished(m_auth->user(), true);
+        } else if (!m_auth->request()->prompts().isEmpty()) {
+            slotRequestChanged();
+        }
+        m_auth->setEnvironmentDeferred(false);
     }
 
-    void Display::slotAuthenticationFinished(const QString &user, bool success) {
+    void Display::slotAuthenticationFinished(const QString &/*user*/, bool success) {
+        // a prepared authentication only counts once the greeter logs in
+        if (!m_preStartedUser.isEmpty()) {
+            m_preAuthenticated = success;
+            return;
+        }
+
         if (success) {
             qDebug() << "Authenticated successfully";
+            daemonApp->metrics()->increment(Metrics::AuthSucceeded);
+            m_seat->loginLimiter()->succeeded(m_auth->user());
 
             if (!m_reuseSessionId.isNull()) {
                 OrgFreedesktopLogin1ManagerInterface manager(Logind::serviceName(), Logind::managerPath(), QDBusConnection::systemBus());
                 manager.UnlockSession(m_reuseSessionId);
                 manager.ActivateSession(m_reuseSessionId);
-            } else {
-                m_auth->setCookie(qobject_cast<XorgDisplayServer *>(m_displayServer)->cookie());
             }
 
             // save last user and last session
@@ -358,11 +621,28 @@ namespace SDDM {
                 stateConfig.Last.Session.setDefault();
             stateConfig.save();
 
-            if (m_socket)
+            if (m_socket) {
+                // the greeter hides instead of quitting and waits for the session to end
+                if (canKeepGreeter()) {
+                    m_greeterResident = true;
+                    emit stayResident(m_socket);
+                }
                 emit loginSucceeded(m_socket);
-        } else if (m_socket) {
-            qDebug() << "Authentication failure";
-            emit loginFailed(m_socket);
+            }
+        } else {
+            daemonApp->metrics()->increment(Metrics::AuthFailed);
+            m_loginTimer.invalidate();
+            // the helper reports failures without a user name, count them
+            // under the name the greeter logged in with
+            if (m_socket)
+                m_seat->loginLimiter()->failed(m_auth->user());
+            else
+                autologinFailed();
+
+            if (m_socket) {
+                qDebug() << "Authentication failure";
+                emit loginFailed(m_socket);
+            }
         }
         m_socket = nullptr;
     }
@@ -384,17 +664,70 @@ namespace SDDM {
             emit loginFailed(m_socket);
     }
 
+    void Display::autologinFailed() {
+        if (!m_autologin)
+            return;
+
+        qWarning() << "Autologin failed, showing the greeter";
+        m_autologin = false;
+
+        // the failed helper must not stop the display when it exits
+        if (m_auth) {
+            Auth *auth = m_auth;
+            m_auth = nullptr;
+            auth->disconnect(this);
+            connect(auth, &Auth::finished, auth, &QObject::deleteLater);
+        }
+
+        // the display server is up already and was waiting for the session
+        if (m_started)
+            startGreeter();
+    }
+
     void Display::slotHelperFinished(Auth::HelperExitStatus status) {
+        if (status == Auth::HELPER_CRASHED)
+            daemonApp->metrics()->increment(Metrics::HelperCrashed);
+
+        // autologin that never got to a session falls back to the greeter
+        if (m_autologin && !m_sessionStarted && status != Auth::HELPER_SUCCESS) {
+            m_auth->deleteLater();
+            m_auth = nullptr;
+            autologinFailed();
+            return;
+        }
+
+        // a prepared authentication that ended on its own is simply redone on login
+        if (!m_preStartedUser.isEmpty()) {
+            m_preStartedUser.clear();
+            m_preAuthenticated = false;
+            m_auth->deleteLater();
+            m_auth = nullptr;
+            return;
+        }
+
         // Don't restart greeter and display server unless sddm-helper exited
         // with an internal error or the user session finished successfully,
         // we want to avoid greeter from restarting when an authentication
         // error happens (in this case we want to show the message from the
         // greeter
-        if (status != Auth::HELPER_AUTH_ERROR)
-            stop();
+        if (status != Auth::HELPER_AUTH_ERROR) {
+            if (m_greeterResident && m_sessionStarted && m_greeter->isRunning())
+                showResidentGreeter();
+            else
+                stop();
+            return;
+        }
+
+        // the next attempt gets a fresh helper
+        m_auth->deleteLater();
+        m_auth = nullptr;
     }
 
     void Display::slotRequestChanged() {
+        // a prepared authentication waits for the password
+        if (!m_preStartedUser.isEmpty())
+            return;
+
         if (m_auth->request()->prompts().length() == 1) {
             m_auth->request()->prompts()[0]->setResponse(qPrintable(m_passPhrase));
             m_auth->request()->done();
@@ -407,5 +740,22 @@ namespace SDDM {
 
     void Display::slotSessionStarted(bool success) {
         qDebug() << "Session started";
+
+        if (success) {
+            daemonApp->metrics()->setSeatState(m_seat->name(), QStringLiteral("session"));
+            if (m_loginTimer.isValid())
+                daemonApp->metrics()->record(Metrics::LoginLatency, m_loginTimer.elapsed());
+            if (m_autologin)
+                qDebug() << "Autologin session started" << daemonApp->uptime() << "ms after the daemon";
+
+            daemonApp->readahead()->record(m_sessionName, m_auth->processId());
+
+            // greeter and socket server are done, unless the greeter stays resident
+            m_sessionStarted = true;
+            m_loggedInFromGreeter = !m_autologin;
+            if (!m_greeterResident)
+                releaseGreeter();
+        }
+        m_loginTimer.invalidate();
     }
 }
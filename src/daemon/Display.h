@@ -24,6 +24,8 @@
 
 #include <QObject>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QTimer>
 
 #include "Auth.h"
 #include "Session.h"
@@ -53,6 +55,12 @@ namespace SDDM {
 
         Seat *seat() const;
 
+        // true while the login screen is up and no session runs here
+        bool isShowingGreeter() const;
+        // true once a user who logged in from the greeter started a
+        // session here, autologin and relogin sessions don't count
+        bool loggedInFromGreeter() const;
+
     public slots:
         bool start();
         void stop();
@@ -63,11 +71,15 @@ namespace SDDM {
         bool attemptAutologin();
         void displayServerStarted();
 
+        // starts authenticating a likely user before the password is known
+        void preselectUser(const QString &user);
+
     signals:
         void stopped();
 
         void loginFailed(QLocalSocket *socket);
         void loginSucceeded(QLocalSocket *socket);
+        void stayResident(QLocalSocket *socket);
 
     private:
         QString findGreeterTheme() const;
@@ -76,16 +88,39 @@ namespace SDDM {
         void startAuth(const QString &user, const QString &password,
                        const Session &session);
 
+        // creates the authenticator if needed
+        Auth *createAuth();
+        void releaseGreeter();
+        void startGreeter();
+        void autologinFailed();
+        bool canKeepGreeter() const;
+        void showResidentGreeter();
+        void abandonPreStart();
+        void logMemoryUsage(const QString &phase) const;
+
         bool m_relogin { true };
         bool m_started { false };
+        bool m_autologin { false };
+        bool m_sessionStarted { false };
+        bool m_loggedInFromGreeter { false };
+        bool m_greeterResident { false };
+        bool m_preAuthenticated { false };
 
         int m_terminalId { 7 };
 
+        qint64 m_startRss { 0 };
+
         Session m_lastSession;
 
+        QElapsedTimer m_loginTimer;
+
         QString m_passPhrase;
         QString m_sessionName;
         QString m_reuseSessionId;
+        QString m_preStartedUser;
+        // user name that arrived while pre-starts were rate limited
+        QString m_preselectUser;
+        QTimer m_preselectTimer;
 
         Auth *m_auth { nullptr };
         DisplayServer *m_displayServer { nullptr };
@@ -101,6 +136,7 @@ namespace SDDM {
         void slotHelperFinished(Auth::HelperExitStatus status);
         void slotAuthInfo(const QString &message, Auth::Info info);
         void slotAuthError(const QString &message, Auth::Error error);
+        void slotGreeterStopped();
     };
 }
 
@@ -0,0 +1,57 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+
+#include "DisplayBackoff.h"
+
+namespace SDDM {
+    // displays that stop sooner than this count as failed
+    static const qint64 s_minimumLifetime = 15000;
+    // restart delays double from the first to the last value
+    static const qint64 s_firstRestartDelay = 1000;
+    static const qint64 s_maximumRestartDelay = 60000;
+    // failures in a row after which the seat falls back to the embedded theme
+    static const int s_crashLoopFailures = 5;
+
+    bool DisplayBackoff::displayStopped(qint64 lifetime, bool loggedInFromGreeter) {
+        // users may log out as quickly as they like, but X servers, greeters
+        // and automatic sessions that die right away are failures
+        if (loggedInFromGreeter || lifetime >= s_minimumLifetime) {
+            m_failures = 0;
+            return false;
+        }
+
+        ++m_failures;
+        return true;
+    }
+
+    int DisplayBackoff::failures() const {
+        return m_failures;
+    }
+
+    bool DisplayBackoff::isCrashLooping() const {
+        return m_failures >= s_crashLoopFailures;
+    }
+
+    qint64 DisplayBackoff::restartDelay() const {
+        if (m_failures == 0)
+            return 0;
+        return qMin(s_firstRestartDelay << qMin(m_failures - 1, 16), s_maximumRestartDelay);
+    }
+}
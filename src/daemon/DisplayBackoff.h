@@ -0,0 +1,53 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+
+#ifndef SDDM_DISPLAYBACKOFF_H
+#define SDDM_DISPLAYBACKOFF_H
+
+#include <QtGlobal>
+
+namespace SDDM {
+    /**
+     * Decides how soon a seat starts a new display after the last one
+     * stopped. Displays that die right away are restarted with a growing
+     * delay, and after a few failures in a row the seat is considered to
+     * be in a crash loop.
+     */
+    class DisplayBackoff {
+        Q_DISABLE_COPY(DisplayBackoff)
+    public:
+        DisplayBackoff() = default;
+
+        // records a display that stopped after running for the given
+        // milliseconds, returns true if that counts as a failure
+        bool displayStopped(qint64 lifetime, bool loggedInFromGreeter);
+
+        int failures() const;
+        bool isCrashLooping() const;
+
+        // milliseconds to wait before the next display, without jitter
+        qint64 restartDelay() const;
+
+    private:
+        int m_failures { 0 };
+    };
+}
+
+#endif // SDDM_DISPLAYBACKOFF_H
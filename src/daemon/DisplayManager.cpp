@@ -20,9 +20,18 @@
 #include "DisplayManager.h"
 
 #include "DaemonApp.h"
+#include "LogindDBusTypes.h"
+#include "Metrics.h"
 #include "SeatManager.h"
 
+#include <QDebug>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+
+#include "Login1Manager.h"
+
 #include "displaymanageradaptor.h"
+#include "metricsadaptor.h"
 #include "seatadaptor.h"
 #include "sessionadaptor.h"
 
@@ -35,6 +44,7 @@ namespace SDDM {
     DisplayManager::DisplayManager(QObject *parent) : QObject(parent) {
         // create adaptor
         new DisplayManagerAdaptor(this);
+        new MetricsAdaptor(this);
 
         // register object
         QDBusConnection connection = (daemonApp->testing()) ? QDBusConnection::sessionBus() : QDBusConnection::systemBus();
@@ -129,6 +139,18 @@ namespace SDDM {
         }
     }
 
+    QVariantMap DisplayManager::Counters() const {
+        return daemonApp->metrics()->counters();
+    }
+
+    QVariantMap DisplayManager::Histograms() const {
+        return daemonApp->metrics()->histograms();
+    }
+
+    QVariantMap DisplayManager::SeatStates() const {
+        return daemonApp->metrics()->seatStates();
+    }
+
     DisplayManagerSeat::DisplayManagerSeat(const QString &name, QObject *parent)
         : QObject(parent), m_name(name), m_path(DISPLAYMANAGER_SEAT_PATH + name.mid(4)) {
         // create adaptor
@@ -149,19 +171,106 @@ namespace SDDM {
     }
 
     void DisplayManagerSeat::SwitchToGreeter() {
-        daemonApp->seatManager()->switchToGreeter(m_name);
+        authorize([this]() {
+            daemonApp->seatManager()->switchToGreeter(m_name);
+        });
     }
 
     void DisplayManagerSeat::SwitchToGuest(const QString &/*session*/) {
-        // TODO: IMPLEMENT
+        authorize([this]() {
+            // there are no guest accounts, offer the login screen instead
+            qWarning() << "Guest accounts are not supported, switching to the greeter";
+            daemonApp->seatManager()->switchToGreeter(m_name);
+        });
     }
 
-    void DisplayManagerSeat::SwitchToUser(const QString &/*user*/, const QString &/*session*/) {
-        // TODO: IMPLEMENT
+    void DisplayManagerSeat::SwitchToUser(const QString &user, const QString &/*session*/) {
+        authorize([this, user]() {
+            daemonApp->seatManager()->switchToUser(m_name, user);
+        });
     }
 
     void DisplayManagerSeat::Lock() {
-        // TODO: IMPLEMENT
+        authorize([this]() {
+            daemonApp->seatManager()->lock(m_name);
+        });
+    }
+
+    void DisplayManagerSeat::authorize(const std::function<void ()> &action) {
+        // calls from within the daemon and test runs need no checks
+        if (!calledFromDBus() || daemonApp->testing()) {
+            action();
+            return;
+        }
+
+        // answer once we know who is calling
+        setDelayedReply(true);
+        const QDBusMessage request = message();
+        QDBusConnection bus = connection();
+
+        auto finish = [this, request, bus, action](bool allowed) {
+            if (!allowed) {
+                qWarning() << "Denied" << request.member() << "on" << m_name << "to" << request.service();
+                bus.send(request.createErrorReply(QDBusError::AccessDenied,
+                                                  QStringLiteral("Only root or the active session on %1 may do this").arg(m_name)));
+                return;
+            }
+
+            action();
+            bus.send(request.createReply());
+        };
+
+        QDBusMessage credentials = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.DBus"), QStringLiteral("/org/freedesktop/DBus"),
+                                                                  QStringLiteral("org.freedesktop.DBus"), QStringLiteral("GetConnectionCredentials"));
+        credentials << request.service();
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(bus.asyncCall(credentials), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, finish]() {
+            watcher->deleteLater();
+
+            QDBusPendingReply<QVariantMap> reply = *watcher;
+            const QVariantMap creds = reply.value();
+            if (reply.isError() || !creds.contains(QStringLiteral("UnixUserID"))) {
+                finish(false);
+                return;
+            }
+
+            // root may always switch
+            if (creds.value(QStringLiteral("UnixUserID")).toUInt() == 0) {
+                finish(true);
+                return;
+            }
+
+            // everybody else has to own the active session on this seat
+            if (!Logind::isAvailable() || !creds.contains(QStringLiteral("ProcessID"))) {
+                finish(false);
+                return;
+            }
+
+            OrgFreedesktopLogin1ManagerInterface manager(Logind::serviceName(), Logind::managerPath(), QDBusConnection::systemBus());
+            QDBusPendingCallWatcher *lookup = new QDBusPendingCallWatcher(manager.GetSessionByPID(creds.value(QStringLiteral("ProcessID")).toUInt()), this);
+            connect(lookup, &QDBusPendingCallWatcher::finished, this, [this, lookup, finish]() {
+                lookup->deleteLater();
+
+                QDBusPendingReply<QDBusObjectPath> reply = *lookup;
+                if (reply.isError()) {
+                    finish(false);
+                    return;
+                }
+
+                QDBusMessage getAll = QDBusMessage::createMethodCall(Logind::serviceName(), reply.value().path(),
+                                                                     QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("GetAll"));
+                getAll << Logind::sessionIfaceName();
+                QDBusPendingCallWatcher *properties = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(getAll), this);
+                connect(properties, &QDBusPendingCallWatcher::finished, this, [this, properties, finish]() {
+                    properties->deleteLater();
+
+                    QDBusPendingReply<QVariantMap> reply = *properties;
+                    const QVariantMap session = reply.value();
+                    const NamedSeatPath seat = qdbus_cast<NamedSeatPath>(session.value(QStringLiteral("Seat")));
+                    finish(!reply.isError() && session.value(QStringLiteral("Active")).toBool() && seat.name == m_name);
+                });
+            });
+        });
     }
 
     ObjectPathList DisplayManagerSeat::Sessions() {
@@ -22,8 +22,12 @@
 
 #include <QObject>
 
+#include <QDBusContext>
 #include <QDBusObjectPath>
 #include <QList>
+#include <QVariantMap>
+
+#include <functional>
 
 namespace SDDM {
     class DisplayManagerSeat;
@@ -55,6 +59,11 @@ namespace SDDM {
         void AddSession(const QString &name, const QString &seat, const QString &user);
         void RemoveSession(const QString &name);
 
+        // org.sddm.Metrics
+        QVariantMap Counters() const;
+        QVariantMap Histograms() const;
+        QVariantMap SeatStates() const;
+
     signals:
         void SeatAdded(ObjectPath seat);
         void SeatRemoved(ObjectPath seat);
@@ -69,7 +78,7 @@ namespace SDDM {
     /***************************************************************************
      * org.freedesktop.DisplayManager.Seat
      **************************************************************************/
-    class DisplayManagerSeat: public QObject {
+    class DisplayManagerSeat: public QObject, protected QDBusContext {
         Q_OBJECT
         Q_DISABLE_COPY(DisplayManagerSeat)
         Q_PROPERTY(bool CanSwitch READ CanSwitch CONSTANT)
@@ -91,6 +100,8 @@ namespace SDDM {
         ObjectPathList Sessions();
 
     private:
+        void authorize(const std::function<void ()> &action);
+
         QString m_name;
         QString m_path;
     };
@@ -23,18 +23,57 @@
 #include "Constants.h"
 #include "DaemonApp.h"
 #include "DisplayManager.h"
+#include "Metrics.h"
 #include "Seat.h"
+#include "SeatResources.h"
 #include "ThemeConfig.h"
 #include "ThemeMetadata.h"
 #include "Display.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
 #include <QtCore/QProcess>
 
 namespace SDDM {
+    static const QString s_virtualKeyboard = QStringLiteral("qtvirtualkeyboard");
+
+    // looks for a touch screen assigned to the seat in the udev database
+    static bool hasTouchScreen(const QString &seat) {
+#ifdef Q_OS_LINUX
+        QDir inputDir(QStringLiteral("/sys/class/input"));
+        const QStringList devices = inputDir.entryList({ QStringLiteral("event*") }, QDir::Dirs | QDir::System);
+        for (const QString &device : devices) {
+            QFile devFile(inputDir.filePath(device + QStringLiteral("/dev")));
+            if (!devFile.open(QIODevice::ReadOnly))
+                continue;
+            const QString devNum = QString::fromLatin1(devFile.readAll().trimmed());
+
+            QFile data(QStringLiteral("/run/udev/data/c%1").arg(devNum));
+            if (!data.open(QIODevice::ReadOnly))
+                continue;
+
+            bool touch = false;
+            QString deviceSeat = QStringLiteral("seat0");
+            while (!data.atEnd()) {
+                const QByteArray line = data.readLine().trimmed();
+                if (line == "E:ID_INPUT_TOUCHSCREEN=1")
+                    touch = true;
+                else if (line.startsWith("E:ID_SEAT="))
+                    deviceSeat = QString::fromLatin1(line.mid(10));
+            }
+            if (touch && deviceSeat == seat)
+                return true;
+        }
+        return false;
+#else
+        Q_UNUSED(seat)
+        // no way to tell, keep the keyboard available
+        return true;
+#endif
+    }
+
     Greeter::Greeter(QObject *parent) : QObject(parent) {
-        m_metadata = new ThemeMetadata(QString());
-        m_themeConfig = new ThemeConfig(QString());
     }
 
     Greeter::~Greeter() {
@@ -59,6 +98,12 @@ namespace SDDM {
     void Greeter::setTheme(const QString &theme) {
         m_themePath = theme;
 
+        // theme objects are only created once a greeter is actually shown
+        if (!m_metadata)
+            m_metadata = new ThemeMetadata(QString());
+        if (!m_themeConfig)
+            m_themeConfig = new ThemeConfig(QString());
+
         if (theme.isEmpty()) {
             m_metadata->setTo(QString());
             m_themeConfig->setTo(QString());
@@ -71,20 +116,41 @@ namespace SDDM {
         }
     }
 
+    bool Greeter::isRunning() const {
+        return m_process || m_auth;
+    }
+
+    QString Greeter::inputMethod() const {
+        const QString method = mainConfig.InputMethod.get();
+        if (method != s_virtualKeyboard)
+            return method;
+
+        // the virtual keyboard is heavy to load, only bring it in when it can be used
+        if (m_themeConfig && m_themeConfig->value(QStringLiteral("needsVirtualKeyboard"), false).toBool())
+            return method;
+        if (hasTouchScreen(m_display->seat()->name()))
+            return method;
+
+        qDebug() << "No touch screen found, not loading the virtual keyboard";
+        return QString();
+    }
+
     bool Greeter::start() {
         // check flag
         if (m_started)
             return false;
 
+        m_startTimer.start();
+
         // themes
         QString xcursorTheme = mainConfig.Theme.CursorTheme.get();
-        if (m_themeConfig->contains(QLatin1String("cursorTheme")))
+        if (m_themeConfig && m_themeConfig->contains(QLatin1String("cursorTheme")))
             xcursorTheme = m_themeConfig->value(QLatin1String("cursorTheme")).toString();
         QString platformTheme;
-        if (m_themeConfig->contains(QLatin1String("platformTheme")))
+        if (m_themeConfig && m_themeConfig->contains(QLatin1String("platformTheme")))
             platformTheme = m_themeConfig->value(QLatin1String("platformTheme")).toString();
         QString style;
-        if (m_themeConfig->contains(QLatin1String("style")))
+        if (m_themeConfig && m_themeConfig->contains(QLatin1String("style")))
             style = m_themeConfig->value(QLatin1String("style")).toString();
 
         // greeter command
@@ -120,13 +186,20 @@ namespace SDDM {
             env.insert(QStringLiteral("DISPLAY"), m_display->name());
             env.insert(QStringLiteral("XAUTHORITY"), m_authPath);
             env.insert(QStringLiteral("XCURSOR_THEME"), xcursorTheme);
-            env.insert(QStringLiteral("QT_IM_MODULE"), mainConfig.InputMethod.get());
+            const QString im = inputMethod();
+            if (!im.isEmpty())
+                env.insert(QStringLiteral("QT_IM_MODULE"), im);
             m_process->setProcessEnvironment(env);
 
             // start greeter
             if (daemonApp->testing())
                 args << QStringLiteral("--test-mode");
-            m_process->start(QStringLiteral("%1/sddm-greeter").arg(QStringLiteral(BIN_INSTALL_DIR)), args);
+
+            // the load test harness replaces the greeter with a scripted client
+            QString greeterPath = QString::fromLocal8Bit(qgetenv("SDDM_TEST_GREETER"));
+            if (greeterPath.isEmpty())
+                greeterPath = QStringLiteral("%1/sddm-greeter").arg(QStringLiteral(BIN_INSTALL_DIR));
+            m_process->start(greeterPath, args);
 
             //if we fail to start bail immediately, and don't block in waitForStarted
             if (m_process->state() == QProcess::NotRunning) {
@@ -142,8 +215,12 @@ namespace SDDM {
                 return false;
             }
 
+            SeatResources::attach(m_display->seat()->name(), m_process->processId());
+
             // log message
             qDebug() << "Greeter started.";
+            daemonApp->metrics()->increment(Metrics::GreeterStarted);
+            daemonApp->metrics()->record(Metrics::GreeterStartTime, m_startTimer.elapsed());
 
             // set flag
             m_started = true;
@@ -162,36 +239,18 @@ namespace SDDM {
             cmd << QStringLiteral("%1/sddm-greeter").arg(QStringLiteral(BIN_INSTALL_DIR))
                 << args;
 
-            // greeter environment
-            QProcessEnvironment env;
-            QProcessEnvironment sysenv = QProcessEnvironment::systemEnvironment();
-
-            insertEnvironmentList({QStringLiteral("LANG"), QStringLiteral("LANGUAGE"),
-                                   QStringLiteral("LC_CTYPE"), QStringLiteral("LC_NUMERIC"), QStringLiteral("LC_TIME"), QStringLiteral("LC_COLLATE"),
-                                   QStringLiteral("LC_MONETARY"), QStringLiteral("LC_MESSAGES"), QStringLiteral("LC_PAPER"), QStringLiteral("LC_NAME"),
-                                   QStringLiteral("LC_ADDRESS"), QStringLiteral("LC_TELEPHONE"), QStringLiteral("LC_MEASUREMENT"), QStringLiteral("LC_IDENTIFICATION"),
-                                   QStringLiteral("LD_LIBRARY_PATH"),
-                                   QStringLiteral("QML2_IMPORT_PATH"),
-                                   QStringLiteral("QT_PLUGIN_PATH"),
-                                   QStringLiteral("XDG_DATA_DIRS")
-            }, sysenv, env);
-
-            env.insert(QStringLiteral("PATH"), mainConfig.Users.DefaultPath.get());
+            // greeter environment, only the per launch variables are added to the seat template
+            QProcessEnvironment env = m_display->seat()->environment()->greeter();
             env.insert(QStringLiteral("DISPLAY"), m_display->name());
             env.insert(QStringLiteral("XAUTHORITY"), m_authPath);
             env.insert(QStringLiteral("XCURSOR_THEME"), xcursorTheme);
-            env.insert(QStringLiteral("XDG_SEAT"), m_display->seat()->name());
-            env.insert(QStringLiteral("XDG_SEAT_PATH"), daemonApp->displayManager()->seatPath(m_display->seat()->name()));
             env.insert(QStringLiteral("XDG_SESSION_PATH"), daemonApp->displayManager()->sessionPath(QStringLiteral("Session%1").arg(daemonApp->newSessionId())));
             if (m_display->seat()->name() == QLatin1String("seat0"))
                 env.insert(QStringLiteral("XDG_VTNR"), QString::number(m_display->terminalId()));
-            env.insert(QStringLiteral("XDG_SESSION_CLASS"), QStringLiteral("greeter"));
             env.insert(QStringLiteral("XDG_SESSION_TYPE"), m_display->sessionType());
-            env.insert(QStringLiteral("QT_IM_MODULE"), mainConfig.InputMethod.get());
-
-            //some themes may use KDE components and that will automatically load KDE's crash handler which we don't want
-            //counterintuitively setting this env disables that handler
-            env.insert(QStringLiteral("KDE_DEBUG"), QStringLiteral("1"));
+            const QString im = inputMethod();
+            if (!im.isEmpty())
+                env.insert(QStringLiteral("QT_IM_MODULE"), im);
             m_auth->insertEnvironment(env);
 
             // log message
@@ -208,12 +267,6 @@ namespace SDDM {
         return true;
     }
 
-    void Greeter::insertEnvironmentList(QStringList names, QProcessEnvironment sourceEnv, QProcessEnvironment &targetEnv) {
-        for (QStringList::const_iterator it = names.constBegin(); it != names.constEnd(); ++it)
-            if (sourceEnv.contains(*it))
-                targetEnv.insert(*it, sourceEnv.value(*it));
-    }
-
     void Greeter::stop() {
         // check flag
         if (!m_started)
@@ -246,6 +299,9 @@ namespace SDDM {
         // clean up
         m_process->deleteLater();
         m_process = nullptr;
+
+        // emit signal
+        emit stopped();
     }
 
     void Greeter::onRequestChanged() {
@@ -257,9 +313,11 @@ namespace SDDM {
         m_started = success;
 
         // log message
-        if (success)
+        if (success) {
             qDebug() << "Greeter session started successfully";
-        else
+            daemonApp->metrics()->increment(Metrics::GreeterStarted);
+            daemonApp->metrics()->record(Metrics::GreeterStartTime, m_startTimer.elapsed());
+        } else
             qDebug() << "Greeter session failed to start";
     }
 
@@ -270,9 +328,15 @@ namespace SDDM {
         // log message
         qDebug() << "Greeter stopped." << status;
 
+        if (status == Auth::HELPER_CRASHED)
+            daemonApp->metrics()->increment(Metrics::HelperCrashed);
+
         // clean up
         m_auth->deleteLater();
         m_auth = nullptr;
+
+        // emit signal
+        emit stopped();
     }
 
     void Greeter::authInfo(const QString &message, Auth::Info info) {
@@ -21,6 +21,7 @@
 #define SDDM_GREETER_H
 
 #include <QObject>
+#include <QElapsedTimer>
 
 #include "Auth.h"
 
@@ -43,6 +44,8 @@ namespace SDDM {
         void setSocket(const QString &socket);
         void setTheme(const QString &theme);
 
+        bool isRunning() const;
+
     public slots:
         bool start();
         void stop();
@@ -55,9 +58,14 @@ namespace SDDM {
         void authInfo(const QString &message, Auth::Info info);
         void authError(const QString &message, Auth::Error error);
 
+    signals:
+        void stopped();
+
     private:
         bool m_started { false };
 
+        QElapsedTimer m_startTimer;
+
         Display *m_display { nullptr };
         QString m_authPath;
         QString m_socket;
@@ -68,7 +76,7 @@ namespace SDDM {
         Auth *m_auth { nullptr };
         QProcess *m_process { nullptr };
 
-        static void insertEnvironmentList(QStringList names, QProcessEnvironment sourceEnv, QProcessEnvironment &targetEnv);
+        QString inputMethod() const;
     };
 }
 
@@ -0,0 +1,112 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+
+#include "GreeterCache.h"
+
+#include "Configuration.h"
+#include "ThemeConfig.h"
+#include "ThemeMetadata.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+
+namespace SDDM {
+    static const QStringList s_fontDirs {
+        QStringLiteral("/usr/share/fonts"),
+        QStringLiteral("/usr/local/share/fonts")
+    };
+    static const QString s_iconDir = QStringLiteral("/usr/share/icons");
+
+    GreeterCache::GreeterCache(QObject *parent) : QObject(parent) {
+        // package updates touch many files at once, wait for them to settle
+        m_refreshTimer.setSingleShot(true);
+        m_refreshTimer.setInterval(10000);
+        connect(&m_refreshTimer, &QTimer::timeout, this, &GreeterCache::refresh);
+        connect(&m_watcher, &QFileSystemWatcher::directoryChanged, &m_refreshTimer, QOverload<>::of(&QTimer::start));
+
+        // start right away so the caches are warm when the first greeter shows up
+        QTimer::singleShot(0, this, &GreeterCache::refresh);
+    }
+
+    void GreeterCache::refresh() {
+        if (!mainConfig.Theme.WarmCaches.get())
+            return;
+
+        // fc-cache only rescans directories that changed since the last run
+        if (!m_fontProcess || m_fontProcess->state() == QProcess::NotRunning) {
+            const QString fcCache = QStandardPaths::findExecutable(QStringLiteral("fc-cache"));
+            if (!fcCache.isEmpty()) {
+                delete m_fontProcess;
+                m_fontProcess = new QProcess(this);
+                m_fontProcess->start(fcCache, QStringList());
+            }
+        }
+        watch(s_fontDirs);
+
+        // the icon cache has to be rebuilt by hand when the theme directory is newer
+        const QString iconTheme = iconThemePath();
+        if (iconTheme.isEmpty())
+            return;
+        watch({ iconTheme });
+
+        const QFileInfo cache(QStringLiteral("%1/icon-theme.cache").arg(iconTheme));
+        if (cache.exists() && cache.lastModified() >= QFileInfo(iconTheme).lastModified())
+            return;
+        if (m_iconProcess && m_iconProcess->state() != QProcess::NotRunning)
+            return;
+
+        const QString updateIconCache = QStandardPaths::findExecutable(QStringLiteral("gtk-update-icon-cache"));
+        if (updateIconCache.isEmpty())
+            return;
+
+        qDebug() << "Updating icon cache of" << iconTheme;
+        delete m_iconProcess;
+        m_iconProcess = new QProcess(this);
+        m_iconProcess->start(updateIconCache, { QStringLiteral("--quiet"), QStringLiteral("--force"), iconTheme });
+    }
+
+    QString GreeterCache::iconThemePath() const {
+        const QString themePath = QStringLiteral("%1/%2").arg(mainConfig.Theme.ThemeDir.get(), mainConfig.Theme.Current.get());
+        if (mainConfig.Theme.Current.get().isEmpty() || !QFileInfo::exists(themePath))
+            return QString();
+
+        ThemeMetadata metadata(QStringLiteral("%1/metadata.desktop").arg(themePath));
+        ThemeConfig config(QStringLiteral("%1/%2").arg(themePath, metadata.configFile()));
+        const QString name = config.value(QStringLiteral("iconTheme")).toString();
+        if (name.isEmpty())
+            return QString();
+
+        const QString path = QStringLiteral("%1/%2").arg(s_iconDir, name);
+        if (!QFileInfo::exists(QStringLiteral("%1/index.theme").arg(path)))
+            return QString();
+        return path;
+    }
+
+    void GreeterCache::watch(const QStringList &paths) {
+        const QStringList watched = m_watcher.directories();
+        for (const QString &path : paths) {
+            if (!watched.contains(path) && QFileInfo(path).isDir())
+                m_watcher.addPath(path);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+
+#ifndef SDDM_GREETERCACHE_H
+#define SDDM_GREETERCACHE_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QTimer>
+
+class QProcess;
+
+namespace SDDM {
+    /**
+     * Keeps the fontconfig cache and the icon cache of the greeter's
+     * icon theme up to date in the background, so that the greeter
+     * does not scan font and icon directories while it starts.
+     */
+    class GreeterCache : public QObject {
+        Q_OBJECT
+        Q_DISABLE_COPY(GreeterCache)
+    public:
+        explicit GreeterCache(QObject *parent = 0);
+
+    public slots:
+        // rebuilds the caches that are older than their directories
+        void refresh();
+
+    private:
+        QString iconThemePath() const;
+        void watch(const QStringList &paths);
+
+        QFileSystemWatcher m_watcher;
+        QTimer m_refreshTimer;
+        QProcess *m_fontProcess { nullptr };
+        QProcess *m_iconProcess { nullptr };
+    };
+}
+
+#endif // SDDM_GREETERCACHE_H
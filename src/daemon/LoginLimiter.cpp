@@ -0,0 +1,70 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+
+#include "LoginLimiter.h"
+
+#include "Configuration.h"
+
+namespace SDDM {
+    // failures that don't cost anything yet
+    static const int s_userFreeAttempts = 3;
+    static const int s_seatFreeAttempts = 10;
+
+    LoginLimiter::LoginLimiter() {
+        m_clock.start();
+    }
+
+    qint64 LoginLimiter::delay(const QString &user) const {
+        const qint64 userDelay = delay(m_users.value(user), s_userFreeAttempts);
+        return qMax(userDelay, delay(m_seat, s_seatFreeAttempts));
+    }
+
+    qint64 LoginLimiter::delay(const Failures &failures, int freeAttempts) const {
+        const qint64 base = qint64(mainConfig.Users.LoginRetryDelay.get()) * 1000;
+        const qint64 max = qint64(mainConfig.Users.LoginRetryMaxDelay.get()) * 1000;
+        if (base <= 0 || failures.count < freeAttempts)
+            return 0;
+
+        // doubles with every failure past the free ones
+        const int doublings = qMin(failures.count - freeAttempts, 20);
+        const qint64 wait = qMin(base << doublings, qMax(max, base));
+        return qMax(qint64(0), failures.last + wait - m_clock.elapsed());
+    }
+
+    void LoginLimiter::record(Failures &failures) {
+        // a quiet period longer than the longest delay starts over
+        const qint64 max = qint64(mainConfig.Users.LoginRetryMaxDelay.get()) * 1000;
+        if (failures.count > 0 && m_clock.elapsed() - failures.last > 2 * max)
+            failures.count = 0;
+
+        ++failures.count;
+        failures.last = m_clock.elapsed();
+    }
+
+    void LoginLimiter::failed(const QString &user) {
+        record(m_users[user]);
+        record(m_seat);
+    }
+
+    void LoginLimiter::succeeded(const QString &user) {
+        m_users.remove(user);
+        m_seat = Failures();
+    }
+}
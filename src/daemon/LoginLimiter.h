@@ -0,0 +1,60 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+
+#ifndef SDDM_LOGINLIMITER_H
+#define SDDM_LOGINLIMITER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+
+namespace SDDM {
+    /**
+     * Exponential back-off after failed logins on a seat, both for each
+     * user and for the seat as a whole. Attempts made before the delay
+     * ran out are rejected without starting a helper.
+     */
+    class LoginLimiter {
+        Q_DISABLE_COPY(LoginLimiter)
+    public:
+        LoginLimiter();
+
+        // milliseconds until the user may try again, 0 when allowed now
+        qint64 delay(const QString &user) const;
+
+        void failed(const QString &user);
+        void succeeded(const QString &user);
+
+    private:
+        struct Failures {
+            int count { 0 };
+            qint64 last { 0 };
+        };
+
+        qint64 delay(const Failures &failures, int freeAttempts) const;
+        void record(Failures &failures);
+
+        QElapsedTimer m_clock;
+        QHash<QString, Failures> m_users;
+        Failures m_seat;
+    };
+}
+
+#endif // SDDM_LOGINLIMITER_H
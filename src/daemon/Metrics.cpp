@@ -0,0 +1,129 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+#include "Metrics.h"
+
+#include <QVariantList>
+
+namespace SDDM {
+    // upper bounds of the histogram buckets, in milliseconds
+    const qint64 Histogram::s_bounds[Histogram::BucketCount] = {
+        10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000
+    };
+
+    static const char *s_counterNames[Metrics::_COUNTER_LAST] = {
+        "AuthSucceeded",
+        "AuthFailed",
+        "AuthThrottled",
+        "HelperCrashed",
+        "GreeterStarted",
+        "DisplayServerStarted",
+        "DisplayRestarted",
+        "DisplayCrashLoop",
+        "SocketMessagesReceived",
+        "SocketMessagesSent"
+    };
+
+    static const char *s_timingNames[Metrics::_TIMING_LAST] = {
+        "LoginLatency",
+        "GreeterStartTime",
+        "DisplayServerStartTime",
+        "UserSwitchLatency"
+    };
+
+    Histogram::Histogram() {
+        for (int i = 0; i <= BucketCount; ++i)
+            m_buckets[i].store(0);
+        m_count.store(0);
+        m_sum.store(0);
+    }
+
+    void Histogram::record(qint64 msecs) {
+        if (msecs < 0)
+            msecs = 0;
+
+        // find the first bucket whose bound is not exceeded
+        int bucket = 0;
+        while (bucket < BucketCount && msecs > s_bounds[bucket])
+            ++bucket;
+
+        m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(quint64(msecs), std::memory_order_relaxed);
+    }
+
+    QVariantMap Histogram::toVariantMap() const {
+        QVariantList bounds;
+        QVariantList buckets;
+
+        for (int i = 0; i < BucketCount; ++i)
+            bounds << qlonglong(s_bounds[i]);
+        for (int i = 0; i <= BucketCount; ++i)
+            buckets << qulonglong(m_buckets[i].load(std::memory_order_relaxed));
+
+        QVariantMap map;
+        map.insert(QStringLiteral("Bounds"), bounds);
+        map.insert(QStringLiteral("Buckets"), buckets);
+        map.insert(QStringLiteral("Count"), qulonglong(m_count.load(std::memory_order_relaxed)));
+        map.insert(QStringLiteral("Sum"), qulonglong(m_sum.load(std::memory_order_relaxed)));
+        return map;
+    }
+
+    Metrics::Metrics(QObject *parent) : QObject(parent) {
+        for (int i = 0; i < _COUNTER_LAST; ++i)
+            m_counters[i].store(0);
+    }
+
+    void Metrics::increment(Counter counter, quint64 amount) {
+        m_counters[counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    void Metrics::record(Timing timing, qint64 msecs) {
+        m_histograms[timing].record(msecs);
+    }
+
+    void Metrics::setSeatState(const QString &seat, const QString &state) {
+        m_seatStates.insert(seat, state);
+    }
+
+    void Metrics::removeSeat(const QString &seat) {
+        m_seatStates.remove(seat);
+    }
+
+    QVariantMap Metrics::counters() const {
+        QVariantMap map;
+        for (int i = 0; i < _COUNTER_LAST; ++i)
+            map.insert(QLatin1String(s_counterNames[i]), qulonglong(m_counters[i].load(std::memory_order_relaxed)));
+        return map;
+    }
+
+    QVariantMap Metrics::histograms() const {
+        QVariantMap map;
+        for (int i = 0; i < _TIMING_LAST; ++i)
+            map.insert(QLatin1String(s_timingNames[i]), m_histograms[i].toVariantMap());
+        return map;
+    }
+
+    QVariantMap Metrics::seatStates() const {
+        QVariantMap map;
+        for (auto it = m_seatStates.constBegin(); it != m_seatStates.constEnd(); ++it)
+            map.insert(it.key(), it.value());
+        return map;
+    }
+}
@@ -0,0 +1,104 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+#ifndef SDDM_METRICS_H
+#define SDDM_METRICS_H
+
+#include <QHash>
+#include <QObject>
+#include <QVariantMap>
+
+#include <atomic>
+
+namespace SDDM {
+    /**
+     * Latency histogram with fixed, exponentially spaced buckets.
+     * Recording a sample is lock free and never allocates.
+     */
+    class Histogram {
+        Q_DISABLE_COPY(Histogram)
+    public:
+        Histogram();
+
+        void record(qint64 msecs);
+
+        QVariantMap toVariantMap() const;
+
+    private:
+        static const int BucketCount = 12;
+        static const qint64 s_bounds[BucketCount];
+
+        // last bucket collects everything above the highest bound
+        std::atomic<quint64> m_buckets[BucketCount + 1];
+        std::atomic<quint64> m_count;
+        std::atomic<quint64> m_sum;
+    };
+
+    /**
+     * Operational counters and timings of the daemon.
+     * They are exported on the system bus through the org.sddm.Metrics
+     * interface of the display manager object.
+     */
+    class Metrics : public QObject {
+        Q_OBJECT
+        Q_DISABLE_COPY(Metrics)
+    public:
+        enum Counter {
+            AuthSucceeded = 0,
+            AuthFailed,
+            AuthThrottled,
+            HelperCrashed,
+            GreeterStarted,
+            DisplayServerStarted,
+            DisplayRestarted,
+            DisplayCrashLoop,
+            SocketMessagesReceived,
+            SocketMessagesSent,
+            _COUNTER_LAST
+        };
+
+        enum Timing {
+            LoginLatency = 0,
+            GreeterStartTime,
+            DisplayServerStartTime,
+            UserSwitchLatency,
+            _TIMING_LAST
+        };
+
+        explicit Metrics(QObject *parent = 0);
+
+        void increment(Counter counter, quint64 amount = 1);
+        void record(Timing timing, qint64 msecs);
+
+        void setSeatState(const QString &seat, const QString &state);
+        void removeSeat(const QString &seat);
+
+        QVariantMap counters() const;
+        QVariantMap histograms() const;
+        QVariantMap seatStates() const;
+
+    private:
+        std::atomic<quint64> m_counters[_COUNTER_LAST];
+        Histogram m_histograms[_TIMING_LAST];
+
+        QHash<QString, QString> m_seatStates;
+    };
+}
+
+#endif // SDDM_METRICS_H
@@ -25,15 +25,26 @@
 
 #include <QDBusConnectionInterface>
 #include <QDBusInterface>
+#include <QDBusPendingCallWatcher>
 #include <QDBusReply>
+#include <QDebug>
+#include <QPointer>
 #include <QProcess>
+#include <QTimer>
+
+#include <functional>
 
 namespace SDDM {
+    // time a power action may take before it is reported as failed
+    static const int POWER_ACTION_TIMEOUT = 30000;
+
     /************************************************/
     /* POWER MANAGER BACKEND                        */
     /************************************************/
     class PowerManagerBackend {
     public:
+        typedef std::function<void (bool success, const QString &error)> Callback;
+
         PowerManagerBackend() {
         }
 
@@ -42,11 +53,55 @@ namespace SDDM {
 
         virtual Capabilities capabilities() const = 0;
 
-        virtual void powerOff() const = 0;
-        virtual void reboot() const = 0;
-        virtual void suspend() const = 0;
-        virtual void hibernate() const = 0;
-        virtual void hybridSleep() const = 0;
+        virtual void powerOff(const Callback &done) const = 0;
+        virtual void reboot(const Callback &done) const = 0;
+        virtual void suspend(const Callback &done) const = 0;
+        virtual void hibernate(const Callback &done) const = 0;
+        virtual void hybridSleep(const Callback &done) const = 0;
+
+    protected:
+        static void runCommand(const QString &command, const Callback &done) {
+            // owned by the application so it is cleaned up even if it never finishes
+            QProcess *process = new QProcess(QCoreApplication::instance());
+
+            QObject::connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), process,
+                             [process, done](int exitCode, QProcess::ExitStatus exitStatus) {
+                if (exitStatus == QProcess::NormalExit && exitCode == 0)
+                    done(true, QString());
+                else
+                    done(false, QStringLiteral("%1 exited with code %2").arg(process->program()).arg(exitCode));
+                process->deleteLater();
+            });
+            QObject::connect(process, &QProcess::errorOccurred, process,
+                             [process, done](QProcess::ProcessError error) {
+                // everything else is followed by finished()
+                if (error != QProcess::FailedToStart)
+                    return;
+                done(false, process->errorString());
+                process->deleteLater();
+            });
+
+            process->start(command);
+
+            // the request itself times out at the same time, don't leave the command behind
+            QTimer::singleShot(POWER_ACTION_TIMEOUT, process, [process] {
+                qWarning() << "Killing" << process->program() << "after timeout";
+                process->kill();
+            });
+        }
+
+        static void watchCall(const QDBusPendingCall &call, const Callback &done) {
+            QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
+
+            QObject::connect(watcher, &QDBusPendingCallWatcher::finished, watcher,
+                             [done](QDBusPendingCallWatcher *watcher) {
+                if (watcher->isError())
+                    done(false, watcher->error().message());
+                else
+                    done(true, QString());
+                watcher->deleteLater();
+            });
+        }
     };
 
     /**********************************************/
@@ -86,23 +141,24 @@ const QString UPOWER_OBJECT = QStringLiteral("org.freedesktop.UPower");
             return caps;
         }
 
-        void powerOff() const {
-            QProcess::execute(mainConfig.HaltCommand.get());
+        void powerOff(const Callback &done) const {
+            runCommand(mainConfig.HaltCommand.get(), done);
         }
 
-        void reboot() const {
-            QProcess::execute(mainConfig.RebootCommand.get());
+        void reboot(const Callback &done) const {
+            runCommand(mainConfig.RebootCommand.get(), done);
         }
 
-        void suspend() const {
-            m_interface->call(QStringLiteral("Suspend"));
+        void suspend(const Callback &done) const {
+            watchCall(m_interface->asyncCall(QStringLiteral("Suspend")), done);
         }
 
-        void hibernate() const {
-            m_interface->call(QStringLiteral("Hibernate"));
+        void hibernate(const Callback &done) const {
+            watchCall(m_interface->asyncCall(QStringLiteral("Hibernate")), done);
         }
 
-        void hybridSleep() const {
+        void hybridSleep(const Callback &done) const {
+            done(false, QStringLiteral("Hybrid sleep is not supported by UPower"));
         }
 
     private:
@@ -165,25 +221,24 @@ const QString CK2_OBJECT = QStringLiteral("org.freedesktop.ConsoleKit.Manager");
             return caps;
         }
 
-        void powerOff() const {
-            m_interface->call(QStringLiteral("PowerOff"), true);
+        void powerOff(const Callback &done) const {
+            watchCall(m_interface->asyncCall(QStringLiteral("PowerOff"), true), done);
         }
 
-        void reboot() const {
-            if (!daemonApp->testing())
-                m_interface->call(QStringLiteral("Reboot"), true);
+        void reboot(const Callback &done) const {
+            watchCall(m_interface->asyncCall(QStringLiteral("Reboot"), true), done);
         }
 
-        void suspend() const {
-            m_interface->call(QStringLiteral("Suspend"), true);
+        void suspend(const Callback &done) const {
+            watchCall(m_interface->asyncCall(QStringLiteral("Suspend"), true), done);
         }
 
-        void hibernate() const {
-            m_interface->call(QStringLiteral("Hibernate"), true);
+        void hibernate(const Callback &done) const {
+            watchCall(m_interface->asyncCall(QStringLiteral("Hibernate"), true), done);
         }
 
-        void hybridSleep() const {
-            m_interface->call(QStringLiteral("HybridSleep"), true);
+        void hybridSleep(const Callback &done) const {
+            watchCall(m_interface->asyncCall(QStringLiteral("HybridSleep"), true), done);
         }
 
     private:
@@ -223,63 +278,98 @@ const QString CK2_OBJECT = QStringLiteral("org.freedesktop.ConsoleKit.Manager");
         return caps;
     }
 
-    void PowerManager::powerOff() const {
-        if (daemonApp->testing())
-            return;
-
-        for (PowerManagerBackend *backend: m_backends) {
-            if (backend->capabilities() & Capability::PowerOff) {
-                backend->powerOff();
-                break;
-            }
-        }
+    quint32 PowerManager::powerOff() {
+        return perform(Capability::PowerOff);
     }
 
-    void PowerManager::reboot() const {
-        if (daemonApp->testing())
-            return;
+    quint32 PowerManager::reboot() {
+        return perform(Capability::Reboot);
+    }
 
-        for (PowerManagerBackend *backend: m_backends) {
-            if (backend->capabilities() & Capability::Reboot) {
-                backend->reboot();
-                break;
-            }
-        }
+    quint32 PowerManager::suspend() {
+        return perform(Capability::Suspend);
     }
 
-    void PowerManager::suspend() const {
-        if (daemonApp->testing())
-            return;
+    quint32 PowerManager::hibernate() {
+        return perform(Capability::Hibernate);
+    }
 
-        for (PowerManagerBackend *backend: m_backends) {
-            if (backend->capabilities() & Capability::Suspend) {
-                backend->suspend();
-                break;
-            }
-        }
+    quint32 PowerManager::hybridSleep() {
+        return perform(Capability::HybridSleep);
     }
 
-    void PowerManager::hibernate() const {
-        if (daemonApp->testing())
-            return;
+    quint32 PowerManager::perform(Capability action) {
+        const quint32 request = ++m_lastRequest;
+        m_pending.insert(request);
+
+        // completion is always reported from the event loop, so that
+        // the caller knows the request identifier before it is used
+        if (daemonApp->testing()) {
+            QTimer::singleShot(0, this, [this, request, action] {
+                complete(request, action, true, QString());
+            });
+            return request;
+        }
 
         for (PowerManagerBackend *backend: m_backends) {
-            if (backend->capabilities() & Capability::Hibernate) {
-                backend->hibernate();
+            if (!(backend->capabilities() & action))
+                continue;
+
+            QPointer<PowerManager> self(this);
+            PowerManagerBackend::Callback done = [self, request, action](bool success, const QString &error) {
+                if (!self)
+                    return;
+                QTimer::singleShot(0, self, [self, request, action, success, error] {
+                    self->complete(request, action, success, error);
+                });
+            };
+
+            switch (action) {
+            case Capability::PowerOff:
+                backend->powerOff(done);
+                break;
+            case Capability::Reboot:
+                backend->reboot(done);
+                break;
+            case Capability::Suspend:
+                backend->suspend(done);
+                break;
+            case Capability::Hibernate:
+                backend->hibernate(done);
+                break;
+            case Capability::HybridSleep:
+                backend->hybridSleep(done);
+                break;
+            default:
                 break;
             }
+
+            // fail the request if the backend does not answer in time
+            QTimer::singleShot(POWER_ACTION_TIMEOUT, this, [this, request, action] {
+                complete(request, action, false, QStringLiteral("Timed out"));
+            });
+
+            return request;
         }
+
+        QTimer::singleShot(0, this, [this, request, action] {
+            complete(request, action, false, QStringLiteral("Action not supported"));
+        });
+        return request;
     }
 
-    void PowerManager::hybridSleep() const {
-        if (daemonApp->testing())
+    void PowerManager::complete(quint32 request, Capability action, bool success, const QString &error) {
+        // already completed or timed out
+        if (!m_pending.remove(request))
             return;
 
-        for (PowerManagerBackend *backend: m_backends) {
-            if (backend->capabilities() & Capability::HybridSleep) {
-                backend->hybridSleep();
-                break;
-            }
-        }
+        // log message
+        if (success)
+            qDebug() << "Power action" << action << "completed.";
+        else
+            qWarning() << "Power action" << action << "failed:" << error;
+
+        // emit signal
+        emit actionFinished(request, quint32(action), success, error);
     }
 }
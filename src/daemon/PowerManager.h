@@ -21,6 +21,7 @@
 #define SDDM_POWERMANAGER_H
 
 #include <QObject>
+#include <QSet>
 #include <QVector>
 
 #include "Messages.h"
@@ -28,6 +29,11 @@
 namespace SDDM {
     class PowerManagerBackend;
 
+    /**
+     * Power actions are dispatched asynchronously, each call returns
+     * a request identifier that is later reported by actionFinished(),
+     * either when the backend completes or when the request times out.
+     */
     class PowerManager : public QObject {
         Q_OBJECT
         Q_DISABLE_COPY(PowerManager)
@@ -38,14 +44,22 @@ namespace SDDM {
     public slots:
         Capabilities capabilities() const;
 
-        void powerOff() const;
-        void reboot() const;
-        void suspend() const;
-        void hibernate() const;
-        void hybridSleep() const;
+        quint32 powerOff();
+        quint32 reboot();
+        quint32 suspend();
+        quint32 hibernate();
+        quint32 hybridSleep();
+
+    signals:
+        void actionFinished(quint32 request, quint32 action, bool success, const QString &error);
 
     private:
+        quint32 perform(Capability action);
+        void complete(quint32 request, Capability action, bool success, const QString &error);
+
         QVector<PowerManagerBackend *> m_backends;
+        QSet<quint32> m_pending;
+        quint32 m_lastRequest { 0 };
     };
 }
 
@@ -23,13 +23,23 @@
 #include "Configuration.h"
 #include "DaemonApp.h"
 #include "Display.h"
+#include "Metrics.h"
+#include "SeatResources.h"
 #include "XorgDisplayServer.h"
 #include "VirtualTerminal.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusVariant>
+
+#include "Login1Manager.h"
 
 #include <functional>
+#include <random>
 
 namespace SDDM {
     int findUnused(int minimum, std::function<bool(const int)> used) {
@@ -44,7 +54,10 @@ namespace SDDM {
         return number;
     }
 
-    Seat::Seat(const QString &name, QObject *parent) : QObject(parent), m_name(name) {
+    Seat::Seat(const QString &name, QObject *parent) : QObject(parent), m_name(name), m_environment(name) {
+        m_restartTimer.setSingleShot(true);
+        connect(&m_restartTimer, &QTimer::timeout, this, &Seat::restartDisplay);
+
         createDisplay();
     }
 
@@ -52,10 +65,25 @@ namespace SDDM {
         return m_name;
     }
 
+    SeatEnvironment *Seat::environment() {
+        return &m_environment;
+    }
+
+    LoginLimiter *Seat::loginLimiter() {
+        return &m_loginLimiter;
+    }
+
+    bool Seat::isCrashLooping() const {
+        return m_backoff.isCrashLooping();
+    }
+
     bool Seat::createDisplay(int terminalId) {
         //reload config if needed
         mainConfig.load();
 
+        // (re)apply the resource limits of this seat
+        SeatResources::prepare(m_name);
+
         if (m_name == QLatin1String("seat0")) {
             if (terminalId == -1) {
                 // find unused terminal
@@ -82,6 +110,7 @@ namespace SDDM {
 
         // add display to the list
         m_displays << display;
+        m_displayStarts.insert(display, daemonApp->uptime());
 
         // start the display
         if (!display->start()) {
@@ -98,6 +127,7 @@ namespace SDDM {
 
         // remove display from list
         m_displays.removeAll(display);
+        m_displayStarts.remove(display);
 
         // mark display and terminal ids as unused
         m_terminalIds.removeAll(display->terminalId());
@@ -111,15 +141,155 @@ namespace SDDM {
         display->deleteLater();
     }
 
+    void Seat::switchToGreeter() {
+        QElapsedTimer timer;
+        timer.start();
+
+        // a login screen that is already up is much cheaper than a new display
+        for (Display *display : qAsConst(m_displays)) {
+            if (!display->isShowingGreeter())
+                continue;
+
+            qDebug() << "Switching to the login screen on display" << display->displayId();
+            if (display->terminalId() != -1)
+                VirtualTerminal::jumpToVt(display->terminalId(), false);
+            daemonApp->metrics()->record(Metrics::UserSwitchLatency, timer.elapsed());
+            return;
+        }
+
+        createDisplay();
+        daemonApp->metrics()->record(Metrics::UserSwitchLatency, timer.elapsed());
+    }
+
+    void Seat::switchToUser(const QString &user) {
+        if (!Logind::isAvailable()) {
+            switchToGreeter();
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        // look for a session the user already has on this seat
+        OrgFreedesktopLogin1ManagerInterface manager(Logind::serviceName(), Logind::managerPath(), QDBusConnection::systemBus());
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(manager.ListSessions(), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, user, timer]() {
+            watcher->deleteLater();
+
+            QDBusPendingReply<SessionInfoList> reply = *watcher;
+            SessionInfoList candidates;
+            for (const SessionInfo &s : reply.value()) {
+                if (s.userName == user && s.seatId == m_name)
+                    candidates << s;
+            }
+
+            activateUserSession(candidates, timer);
+        });
+    }
+
+    void Seat::activateUserSession(SessionInfoList candidates, QElapsedTimer timer) {
+        // no session yet, the user logs in from the login screen
+        if (candidates.isEmpty()) {
+            switchToGreeter();
+            return;
+        }
+
+        // only switch to sessions we started, one property read at a time
+        const SessionInfo s = candidates.takeFirst();
+        QDBusMessage get = QDBusMessage::createMethodCall(Logind::serviceName(), s.sessionPath.path(),
+                                                          QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("Get"));
+        get << Logind::sessionIfaceName() << QStringLiteral("Service");
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(get), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, s, candidates, timer]() {
+            watcher->deleteLater();
+
+            QDBusPendingReply<QDBusVariant> reply = *watcher;
+            if (reply.isError() || reply.value().variant().toString() != QLatin1String("sddm")) {
+                activateUserSession(candidates, timer);
+                return;
+            }
+
+            // logind takes care of the VT switch
+            qDebug() << "Switching to session" << s.sessionId << "of user" << s.userName;
+            OrgFreedesktopLogin1ManagerInterface manager(Logind::serviceName(), Logind::managerPath(), QDBusConnection::systemBus());
+            QDBusPendingCallWatcher *activation = new QDBusPendingCallWatcher(manager.ActivateSession(s.sessionId), this);
+            connect(activation, &QDBusPendingCallWatcher::finished, this, [activation, timer]() {
+                activation->deleteLater();
+                if (activation->isError())
+                    qWarning() << "Failed to activate session:" << activation->error().message();
+                else
+                    daemonApp->metrics()->record(Metrics::UserSwitchLatency, timer.elapsed());
+            });
+        });
+    }
+
+    void Seat::lock() {
+        if (Logind::isAvailable()) {
+            OrgFreedesktopLogin1ManagerInterface manager(Logind::serviceName(), Logind::managerPath(), QDBusConnection::systemBus());
+            QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(manager.ListSessions(), this);
+            connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher]() {
+                watcher->deleteLater();
+
+                // ask the lock screens of all sessions on this seat to come up
+                QDBusPendingReply<SessionInfoList> reply = *watcher;
+                const SessionInfoList sessions = reply.value();
+                OrgFreedesktopLogin1ManagerInterface manager(Logind::serviceName(), Logind::managerPath(), QDBusConnection::systemBus());
+                for (const SessionInfo &s : sessions) {
+                    if (s.seatId != m_name)
+                        continue;
+
+                    QDBusPendingCallWatcher *locking = new QDBusPendingCallWatcher(manager.LockSession(s.sessionId), this);
+                    connect(locking, &QDBusPendingCallWatcher::finished, this, [locking]() {
+                        locking->deleteLater();
+                        if (locking->isError())
+                            qWarning() << "Failed to lock session:" << locking->error().message();
+                    });
+                }
+            });
+        }
+
+        switchToGreeter();
+    }
+
+    void Seat::restartDisplay() {
+        if (m_displays.isEmpty())
+            createDisplay();
+    }
+
     void Seat::displayStopped() {
         Display *display = qobject_cast<Display *>(sender());
 
+        // displays that die right away are restarted with a growing delay
+        const bool wasCrashLooping = isCrashLooping();
+        const qint64 lifetime = daemonApp->uptime() - m_displayStarts.value(display, 0);
+        if (m_backoff.displayStopped(lifetime, display->loggedInFromGreeter())) {
+            if (!wasCrashLooping && isCrashLooping()) {
+                qCritical() << "Displays on" << m_name << "keep failing, falling back to the embedded theme without autologin";
+                daemonApp->metrics()->increment(Metrics::DisplayCrashLoop);
+            }
+        } else if (wasCrashLooping) {
+            qDebug() << "Display on" << m_name << "stayed up, leaving the fallback mode";
+        }
+
         // remove display
         removeDisplay(display);
 
         // restart otherwise
         if (m_displays.isEmpty()) {
-            createDisplay();
+            daemonApp->metrics()->increment(Metrics::DisplayRestarted);
+            const qint64 delay = m_backoff.restartDelay();
+            if (delay == 0) {
+                createDisplay();
+                return;
+            }
+
+            // +-20% jitter keeps several failing seats from restarting in lockstep
+            static std::mt19937 generator { std::random_device()() };
+            std::uniform_int_distribution<qint64> jitter(-delay / 5, delay / 5);
+            const qint64 wait = delay + jitter(generator);
+
+            qWarning() << "Display on" << m_name << "failed" << m_backoff.failures() << "times in a row, restarting in" << wait << "ms";
+            m_restartTimer.start(int(wait));
         }
         // If there is still a session running on some display,
         // switch to last display in display vector.
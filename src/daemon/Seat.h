@@ -20,9 +20,17 @@
 #ifndef SDDM_SEAT_H
 #define SDDM_SEAT_H
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
+#include <QTimer>
 #include <QVector>
 
+#include "DisplayBackoff.h"
+#include "LoginLimiter.h"
+#include "LogindDBusTypes.h"
+#include "SeatEnvironment.h"
+
 namespace SDDM {
     class Display;
 
@@ -33,19 +41,38 @@ namespace SDDM {
         explicit Seat(const QString &name, QObject *parent = 0);
 
         const QString &name() const;
+        SeatEnvironment *environment();
+        LoginLimiter *loginLimiter();
+
+        // true after displays kept dying right after being started
+        bool isCrashLooping() const;
 
     public slots:
         bool createDisplay(int terminalId = -1);
         void removeDisplay(SDDM::Display* display);
 
+        void switchToGreeter();
+        void switchToUser(const QString &user);
+        void lock();
+
     private slots:
         void displayStopped();
+        void restartDisplay();
 
     private:
+        void activateUserSession(SessionInfoList candidates, QElapsedTimer timer);
+
         QString m_name;
+        SeatEnvironment m_environment;
+        LoginLimiter m_loginLimiter;
 
         QVector<Display *> m_displays;
         QVector<int> m_terminalIds;
+
+        // daemon uptime at which each display was created
+        QHash<Display *, qint64> m_displayStarts;
+        DisplayBackoff m_backoff;
+        QTimer m_restartTimer;
     };
 }
 
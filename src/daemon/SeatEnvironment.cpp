@@ -0,0 +1,86 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+#include "SeatEnvironment.h"
+
+#include "Configuration.h"
+#include "DaemonApp.h"
+#include "DisplayManager.h"
+
+namespace SDDM {
+    // variables the greeter inherits from the daemon
+    static const char *s_greeterInherited[] = {
+        "LANG", "LANGUAGE",
+        "LC_CTYPE", "LC_NUMERIC", "LC_TIME", "LC_COLLATE",
+        "LC_MONETARY", "LC_MESSAGES", "LC_PAPER", "LC_NAME",
+        "LC_ADDRESS", "LC_TELEPHONE", "LC_MEASUREMENT", "LC_IDENTIFICATION",
+        "LD_LIBRARY_PATH",
+        "QML2_IMPORT_PATH",
+        "QT_PLUGIN_PATH",
+        "XDG_DATA_DIRS"
+    };
+
+    SeatEnvironment::SeatEnvironment(const QString &seat) : m_seat(seat) {
+    }
+
+    QProcessEnvironment SeatEnvironment::greeter() {
+        update();
+        return m_greeter;
+    }
+
+    QProcessEnvironment SeatEnvironment::session() {
+        update();
+        return m_session;
+    }
+
+    void SeatEnvironment::update() {
+        if (m_valid && m_generation == mainConfig.generation())
+            return;
+
+        m_valid = true;
+        m_generation = mainConfig.generation();
+
+        const QString path = mainConfig.Users.DefaultPath.get();
+        const QString seatPath = daemonApp->displayManager()->seatPath(m_seat);
+
+        // greeter
+        const QProcessEnvironment sysenv = QProcessEnvironment::systemEnvironment();
+        m_greeter = QProcessEnvironment();
+        for (const char *name : s_greeterInherited) {
+            const QString key = QLatin1String(name);
+            if (sysenv.contains(key))
+                m_greeter.insert(key, sysenv.value(key));
+        }
+        m_greeter.insert(QStringLiteral("PATH"), path);
+        m_greeter.insert(QStringLiteral("XDG_SEAT"), m_seat);
+        m_greeter.insert(QStringLiteral("XDG_SEAT_PATH"), seatPath);
+        m_greeter.insert(QStringLiteral("XDG_SESSION_CLASS"), QStringLiteral("greeter"));
+
+        //some themes may use KDE components and that will automatically load KDE's crash handler which we don't want
+        //counterintuitively setting this env disables that handler
+        m_greeter.insert(QStringLiteral("KDE_DEBUG"), QStringLiteral("1"));
+
+        // user session
+        m_session = QProcessEnvironment();
+        m_session.insert(QStringLiteral("PATH"), path);
+        m_session.insert(QStringLiteral("XDG_SEAT"), m_seat);
+        m_session.insert(QStringLiteral("XDG_SEAT_PATH"), seatPath);
+        m_session.insert(QStringLiteral("XDG_SESSION_CLASS"), QStringLiteral("user"));
+    }
+}
@@ -0,0 +1,51 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+#ifndef SDDM_SEATENVIRONMENT_H
+#define SDDM_SEATENVIRONMENT_H
+
+#include <QProcessEnvironment>
+
+namespace SDDM {
+    /**
+     * Environment shared by every greeter and session started on a seat.
+     * The templates are built once and only rebuilt after the configuration
+     * was reloaded, callers add the per launch variables on top.
+     */
+    class SeatEnvironment {
+        Q_DISABLE_COPY(SeatEnvironment)
+    public:
+        explicit SeatEnvironment(const QString &seat);
+
+        QProcessEnvironment greeter();
+        QProcessEnvironment session();
+
+    private:
+        void update();
+
+        QString m_seat;
+        bool m_valid { false };
+        uint m_generation { 0 };
+
+        QProcessEnvironment m_greeter;
+        QProcessEnvironment m_session;
+    };
+}
+
+#endif // SDDM_SEATENVIRONMENT_H
@@ -20,12 +20,18 @@
 #include "SeatManager.h"
 
 #include "DaemonApp.h"
+#include "Metrics.h"
 #include "Seat.h"
+#include "SeatResources.h"
 
 #include <QDBusConnection>
 #include <QDBusMessage>
 #include <QDBusPendingReply>
 #include <QDBusContext>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QTimer>
 
 #include "LogindDBusTypes.h"
 
@@ -62,11 +68,9 @@ namespace SDDM {
             if (!reply.isValid())
                 return;
 
-            bool value = reply.value().toBool();
-            if (value != m_canGraphical) {
-                m_canGraphical = value;
-                emit canGraphicalChanged(m_canGraphical);
-            }
+            // always reported, a seat may have been started before logind answered
+            m_canGraphical = reply.value().toBool();
+            emit canGraphicalChanged(m_canGraphical);
         });
     }
 
@@ -100,6 +104,14 @@ namespace SDDM {
             return;
         }
 
+        // seat0 is graphical on almost every machine, start it while logind is asked
+        if (canStartSeat0()) {
+            qDebug() << "Starting seat0 before logind enumerated the seats";
+            m_speculativeSeat0 = true;
+            m_speculationTimer.start();
+            createSeat(QStringLiteral("seat0"));
+        }
+
         //fetch seats
         auto listSeatsMsg = QDBusMessage::createMethodCall(Logind::serviceName(), Logind::managerPath(), Logind::managerIfaceName(), QStringLiteral("ListSeats"));
         QDBusPendingReply<NamedSeatPathList> reply = QDBusConnection::systemBus().asyncCall(listSeatsMsg);
@@ -107,17 +119,48 @@ namespace SDDM {
         QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply);
         connect(watcher, &QDBusPendingCallWatcher::finished, this, [=]() {
             watcher->deleteLater();
+            if (reply.isError()) {
+                // keep a speculatively started seat0, like without logind
+                m_speculativeSeat0 = false;
+                return;
+            }
             const auto seats = reply.value();
+            bool hasSeat0 = false;
             for(const NamedSeatPath &seat : seats) {
+                hasSeat0 |= seat.name == QLatin1String("seat0");
                 logindSeatAdded(seat.name, seat.path);
             }
+            if (!hasSeat0 && m_speculativeSeat0)
+                seat0Confirmed(false);
         });
 
         QDBusConnection::systemBus().connect(Logind::serviceName(), Logind::managerPath(), Logind::managerIfaceName(), QStringLiteral("SeatNew"), this, SLOT(logindSeatAdded(QString,QDBusObjectPath)));
         QDBusConnection::systemBus().connect(Logind::serviceName(), Logind::managerPath(), Logind::managerIfaceName(), QStringLiteral("SeatRemoved"), this, SLOT(logindSeatRemoved(QString,QDBusObjectPath)));
     }
 
+    bool SeatManager::canStartSeat0() const {
+        if (!QFile::exists(QStringLiteral("/dev/tty0")))
+            return false;
+        const QStringList cards = QDir(QStringLiteral("/dev/dri")).entryList({ QStringLiteral("card*") }, QDir::System);
+        return !cards.isEmpty();
+    }
+
+    void SeatManager::seat0Confirmed(bool graphical) {
+        m_speculativeSeat0 = false;
+
+        if (graphical) {
+            qDebug() << "logind confirmed seat0" << m_speculationTimer.elapsed() << "ms after it was started";
+        } else {
+            qWarning() << "logind has no graphical seat0, stopping the speculatively started one";
+            removeSeat(QStringLiteral("seat0"));
+        }
+    }
+
     void SeatManager::createSeat(const QString &name) {
+        // a seat may already be running when logind reports it
+        if (m_seats.contains(name))
+            return;
+
         // create a seat
         Seat *seat = new Seat(name, this);
 
@@ -136,26 +179,66 @@ namespace SDDM {
         // remove from the list
         Seat *seat = m_seats.take(name);
 
-        // delete seat
+        // delete seat, its control group goes once the processes are gone
+        connect(seat, &QObject::destroyed, this, [this, name]() {
+            releaseResources(name, 10);
+        });
         seat->deleteLater();
+        daemonApp->metrics()->removeSeat(name);
 
         // emit signal
         emit seatRemoved(name);
     }
 
+    void SeatManager::releaseResources(const QString &name, int attempts) {
+        // the seat came back and uses the group again
+        if (m_seats.contains(name) || SeatResources::release(name))
+            return;
+
+        // display stop scripts and killed servers may take a moment to exit
+        if (attempts > 1) {
+            QTimer::singleShot(1000, this, [this, name, attempts]() {
+                releaseResources(name, attempts - 1);
+            });
+        } else {
+            qWarning() << "Processes are left in the control group of" << name;
+        }
+    }
+
     void SeatManager::switchToGreeter(const QString &name) {
         // check if seat exists
         if (!m_seats.contains(name))
             return;
 
         // switch to greeter
-        m_seats.value(name)->createDisplay();
+        m_seats.value(name)->switchToGreeter();
+    }
+
+    void SeatManager::switchToUser(const QString &name, const QString &user) {
+        // check if seat exists
+        if (!m_seats.contains(name))
+            return;
+
+        m_seats.value(name)->switchToUser(user);
+    }
+
+    void SeatManager::lock(const QString &name) {
+        // check if seat exists
+        if (!m_seats.contains(name))
+            return;
+
+        m_seats.value(name)->lock();
     }
 
     void SDDM::SeatManager::logindSeatAdded(const QString& name, const QDBusObjectPath& objectPath)
     {
         auto logindSeat = new LogindSeat(name, objectPath, this);
         connect(logindSeat, &LogindSeat::canGraphicalChanged, this, [=]() {
+            if (m_speculativeSeat0 && logindSeat->name() == QLatin1String("seat0")) {
+                seat0Confirmed(logindSeat->canGraphical());
+                return;
+            }
+
             if (logindSeat->canGraphical()) {
                 createSeat(logindSeat->name());
             } else {
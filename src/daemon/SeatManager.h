@@ -21,6 +21,7 @@
 #define SDDM_SEATMANAGER_H
 
 #include <QObject>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QDBusObjectPath>
 
@@ -37,6 +38,8 @@ namespace SDDM {
         void createSeat(const QString &name);
         void removeSeat(const QString &name);
         void switchToGreeter(const QString &seat);
+        void switchToUser(const QString &seat, const QString &user);
+        void lock(const QString &seat);
 
     Q_SIGNALS:
         void seatCreated(const QString &name);
@@ -47,8 +50,16 @@ namespace SDDM {
         void logindSeatRemoved(const QString &name, const QDBusObjectPath &objectPath);
 
     private:
+        bool canStartSeat0() const;
+        void seat0Confirmed(bool graphical);
+        void releaseResources(const QString &name, int attempts);
+
         QHash<QString, Seat *> m_seats; //these will exist only for graphical seats
         QHash<QString, LogindSeat*> m_systemSeats; //these will exist for all seats
+
+        // seat0 started before logind listed it
+        bool m_speculativeSeat0 { false };
+        QElapsedTimer m_speculationTimer;
     };
 }
 
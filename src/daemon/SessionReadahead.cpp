@@ -0,0 +1,270 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+#include "SessionReadahead.h"
+
+#include "Configuration.h"
+#include "Constants.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSocketNotifier>
+#include <QThread>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/fanotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace SDDM {
+    // profiles are recorded again once they are older than this
+    static const int PROFILE_MAX_AGE_DAYS = 7;
+    // upper bound of files in a profile
+    static const int PROFILE_MAX_FILES = 8192;
+
+    // files outside of these are either virtual, volatile or private to a user
+    static const char *s_ignoredPrefixes[] = {
+        "/proc/", "/sys/", "/dev/", "/run/", "/tmp/", "/var/tmp/", "/home/", "/root/"
+    };
+
+    /**
+     * Asks the kernel to read a list of files into the page cache.
+     * Runs on its own thread since opening thousands of files on a
+     * cold cache takes a while.
+     */
+    class PrefetchThread : public QThread {
+    public:
+        explicit PrefetchThread(const QString &profile, QObject *parent)
+            : QThread(parent), m_profile(profile) { }
+
+    protected:
+        void run() override {
+            QFile file(m_profile);
+            if (!file.open(QIODevice::ReadOnly))
+                return;
+
+            int count = 0;
+            while (!file.atEnd()) {
+                const QByteArray path = file.readLine().trimmed();
+                if (path.isEmpty())
+                    continue;
+
+                // fifos or device nodes must not block the thread
+                int fd = open(path.constData(), O_RDONLY | O_CLOEXEC | O_NONBLOCK | O_NOATIME);
+                if (fd < 0 && errno == EPERM)
+                    fd = open(path.constData(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+                if (fd < 0)
+                    continue;
+
+                posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+                close(fd);
+                count++;
+            }
+
+            qDebug() << "Readahead: prefetched" << count << "files from" << m_profile;
+        }
+
+    private:
+        QString m_profile;
+    };
+
+    SessionReadahead::SessionReadahead(QObject *parent) : QObject(parent) {
+        m_recordTimer.setSingleShot(true);
+        connect(&m_recordTimer, &QTimer::timeout, this, &SessionReadahead::finishRecording);
+    }
+
+    SessionReadahead::~SessionReadahead() {
+        if (m_fanotify >= 0)
+            close(m_fanotify);
+    }
+
+    QString SessionReadahead::profilePath(const QString &session) const {
+        // session names are desktop file names, keep them from escaping the directory
+        QString name = session;
+        name.replace(QLatin1Char('/'), QLatin1Char('_'));
+        return QStringLiteral("%1/readahead/%2.files").arg(QStringLiteral(STATE_DIR), name);
+    }
+
+    void SessionReadahead::prefetch(const QString &session) {
+        if (!mainConfig.Readahead.Enabled.get() || session.isEmpty())
+            return;
+
+        // the same profile is read at most once at a time
+        if (m_prefetching == session)
+            return;
+
+        const QString path = profilePath(session);
+        if (!QFile::exists(path))
+            return;
+
+        m_prefetching = session;
+        PrefetchThread *thread = new PrefetchThread(path, this);
+        connect(thread, &QThread::finished, this, [this, thread, session] {
+            if (m_prefetching == session)
+                m_prefetching.clear();
+            thread->deleteLater();
+        });
+        thread->start(QThread::LowPriority);
+    }
+
+    void SessionReadahead::record(const QString &session, qint64 rootPid) {
+        if (!mainConfig.Readahead.Enabled.get() || session.isEmpty() || rootPid <= 0)
+            return;
+
+        // one recording at a time, the events can't be told apart per session
+        if (m_fanotify >= 0)
+            return;
+
+        QFileInfo profile(profilePath(session));
+        if (profile.exists() && profile.lastModified().daysTo(QDateTime::currentDateTime()) < PROFILE_MAX_AGE_DAYS)
+            return;
+
+        m_fanotify = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK,
+                                   O_RDONLY | O_LARGEFILE | O_CLOEXEC | O_NOATIME);
+        if (m_fanotify < 0) {
+            qWarning() << "Readahead: fanotify is not available:" << strerror(errno);
+            return;
+        }
+
+        // binaries and libraries usually live on the root or /usr mount
+        bool marked = false;
+        for (const char *mount : { "/", "/usr" }) {
+            if (fanotify_mark(m_fanotify, FAN_MARK_ADD | FAN_MARK_MOUNT, FAN_OPEN, AT_FDCWD, mount) == 0)
+                marked = true;
+        }
+        if (!marked) {
+            qWarning() << "Readahead: failed to watch the root file system:" << strerror(errno);
+            close(m_fanotify);
+            m_fanotify = -1;
+            return;
+        }
+
+        qDebug() << "Readahead: recording the startup of session" << session;
+
+        m_recording = session;
+        m_rootPid = rootPid;
+        m_files.clear();
+        m_sessionPids.clear();
+        m_notifier = new QSocketNotifier(m_fanotify, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated, this, &SessionReadahead::readEvents);
+        m_recordTimer.start(mainConfig.Readahead.RecordTime.get() * 1000);
+    }
+
+    void SessionReadahead::readEvents() {
+        alignas(struct fanotify_event_metadata) char buffer[8192];
+        const pid_t self = getpid();
+
+        forever {
+            ssize_t length = read(m_fanotify, buffer, sizeof(buffer));
+            if (length <= 0)
+                return;
+
+            const struct fanotify_event_metadata *event = reinterpret_cast<struct fanotify_event_metadata *>(buffer);
+            for (; FAN_EVENT_OK(event, length); event = FAN_EVENT_NEXT(event, length)) {
+                if (event->vers != FANOTIFY_METADATA_VERSION || event->fd < 0)
+                    continue;
+
+                struct stat info;
+                // the mounts are shared, keep only what the session opens
+                if (event->pid != self && m_files.size() < PROFILE_MAX_FILES && isInSession(event->pid) &&
+                        fstat(event->fd, &info) == 0 && S_ISREG(info.st_mode)) {
+                    char path[PATH_MAX];
+                    const QByteArray link = "/proc/self/fd/" + QByteArray::number(event->fd);
+                    ssize_t size = readlink(link.constData(), path, sizeof(path) - 1);
+                    if (size > 0) {
+                        const QString file = QString::fromLocal8Bit(path, int(size));
+                        bool ignored = false;
+                        for (const char *prefix : s_ignoredPrefixes)
+                            ignored = ignored || file.startsWith(QLatin1String(prefix));
+                        if (!ignored)
+                            m_files.insert(file);
+                    }
+                }
+                close(event->fd);
+            }
+        }
+    }
+
+    bool SessionReadahead::isInSession(qint64 pid) {
+        // walk up the parents until the session root or init shows up
+        QList<qint64> chain;
+        bool found = false;
+        while (pid > 1) {
+            auto cached = m_sessionPids.constFind(pid);
+            if (cached != m_sessionPids.constEnd()) {
+                found = cached.value();
+                break;
+            }
+            if (pid == m_rootPid) {
+                found = true;
+                break;
+            }
+            chain << pid;
+
+            // the parent follows the state after the command name, which may contain ')'
+            QFile stat(QStringLiteral("/proc/%1/stat").arg(pid));
+            if (!stat.open(QIODevice::ReadOnly))
+                break;
+            const QByteArray line = stat.readAll();
+            const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+            pid = fields.size() > 1 ? fields.at(1).toLongLong() : 0;
+        }
+
+        for (qint64 p : qAsConst(chain))
+            m_sessionPids.insert(p, found);
+        return found;
+    }
+
+    void SessionReadahead::finishRecording() {
+        // pick up what is still queued
+        readEvents();
+
+        m_notifier->deleteLater();
+        m_notifier = nullptr;
+        close(m_fanotify);
+        m_fanotify = -1;
+
+        QDir().mkpath(QStringLiteral("%1/readahead").arg(QStringLiteral(STATE_DIR)));
+
+        // the list shows what a user runs, keep it to root
+        QSaveFile file(profilePath(m_recording));
+        if (file.open(QIODevice::WriteOnly) && file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner)) {
+            for (const QString &path : qAsConst(m_files)) {
+                file.write(path.toLocal8Bit());
+                file.write("\n");
+            }
+            if (file.commit())
+                qDebug() << "Readahead: recorded" << m_files.size() << "files for session" << m_recording;
+        } else {
+            qWarning() << "Readahead: failed to write the profile" << file.fileName();
+        }
+
+        m_files.clear();
+        m_sessionPids.clear();
+        m_recording.clear();
+        m_rootPid = 0;
+    }
+}
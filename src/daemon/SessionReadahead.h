@@ -0,0 +1,69 @@
+/***************************************************************************
+* Copyright (c) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the
+* Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+***************************************************************************/
+
+#ifndef SDDM_SESSIONREADAHEAD_H
+#define SDDM_SESSIONREADAHEAD_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+class QSocketNotifier;
+
+namespace SDDM {
+    /**
+     * Records which files a session opens while it starts up and reads
+     * them into the page cache on later logins, while the greeter is
+     * still waiting for the password.
+     */
+    class SessionReadahead : public QObject {
+        Q_OBJECT
+        Q_DISABLE_COPY(SessionReadahead)
+    public:
+        explicit SessionReadahead(QObject *parent = 0);
+        ~SessionReadahead();
+
+        // starts reading the profile of the session in the background
+        void prefetch(const QString &session);
+        // records a profile for the session started below the given
+        // process, unless a recent one exists
+        void record(const QString &session, qint64 rootPid);
+
+    private slots:
+        void readEvents();
+        void finishRecording();
+
+    private:
+        QString profilePath(const QString &session) const;
+        bool isInSession(qint64 pid);
+
+        int m_fanotify { -1 };
+        QSocketNotifier *m_notifier { nullptr };
+        QTimer m_recordTimer;
+        QString m_recording;
+        qint64 m_rootPid { 0 };
+        // processes already looked up, true for those of the session
+        QHash<qint64, bool> m_sessionPids;
+        QSet<QString> m_files;
+        QString m_prefetching;
+    };
+}
+
+#endif // SDDM_SESSIONREADAHEAD_H
@@ -17,221 +17,113 @@
 * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 ***************************************************************************/
 
+
 #include "SignalHandler.h"
 
 #include <QDebug>
 #include <QSocketNotifier>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <unistd.h>
 
 #include <sys/socket.h>
 
 namespace SDDM {
-    int sighupFd[2];
-    int sigintFd[2];
-    int sigtermFd[2];
-    int sigusr1Fd[2];
+    // the handler marks the signal as pending and wakes up the event loop
+    // through the socket, so a full socket never loses a signal
+    int signalFd[2];
+    static volatile sig_atomic_t pendingSignals[NSIG];
 
     SignalHandler::SignalHandler(QObject *parent) : QObject(parent) {
-        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sighupFd))
-            qCritical() << "Failed to create socket pair for SIGHUP handling.";
-
-        snhup = new QSocketNotifier(sighupFd[1], QSocketNotifier::Read, this);
-        connect(snhup, &QSocketNotifier::activated, this, &SignalHandler::handleSighup);
-
-        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sigintFd))
-            qCritical() << "Failed to create socket pair for SIGINT handling.";
-
-        snint = new QSocketNotifier(sigintFd[1], QSocketNotifier::Read, this);
-        connect(snint, &QSocketNotifier::activated, this, &SignalHandler::handleSigint);
-
-        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sigtermFd))
-            qCritical() << "Failed to create socket pair for SIGTERM handling.";
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, signalFd)) {
+            qCritical() << "Failed to create socket pair for signal handling.";
+            return;
+        }
 
-        snterm = new QSocketNotifier(sigtermFd[1], QSocketNotifier::Read, this);
-        connect(snterm, &QSocketNotifier::activated, this, &SignalHandler::handleSigterm);
+        // the handler must never block and the reader drains everything at once
+        fcntl(signalFd[0], F_SETFL, fcntl(signalFd[0], F_GETFL) | O_NONBLOCK);
+        fcntl(signalFd[1], F_SETFL, fcntl(signalFd[1], F_GETFL) | O_NONBLOCK);
 
-        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sigusr1Fd))
-            qCritical() << "Failed to create socket pair for SIGUSR1 handling.";
+        m_notifier = new QSocketNotifier(signalFd[1], QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated, this, &SignalHandler::readSignals);
+    }
 
-        snusr1 = new QSocketNotifier(sigusr1Fd[1], QSocketNotifier::Read, this);
-        connect(snusr1, &QSocketNotifier::activated, this, &SignalHandler::handleSigusr1);
+    static bool installHandler(int signo, void (*handler)(int)) {
+        struct sigaction action = { };
+        action.sa_handler = handler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        return sigaction(signo, &action, 0) == 0;
     }
 
     void SignalHandler::initialize() {
-        struct sigaction sighup = { };
-        sighup.sa_handler = SignalHandler::hupSignalHandler;
-        sigemptyset(&sighup.sa_mask);
-        sighup.sa_flags = SA_RESTART;
-
-        if (sigaction(SIGHUP, &sighup, 0) > 0) {
+        if (!installHandler(SIGHUP, SignalHandler::signalHandler)) {
             qCritical() << "Failed to setup SIGHUP handler.";
             return;
         }
 
-        struct sigaction sigint = { };
-        sigint.sa_handler = SignalHandler::intSignalHandler;
-        sigemptyset(&sigint.sa_mask);
-        sigint.sa_flags = SA_RESTART;
-
-        if (sigaction(SIGINT, &sigint, 0) > 0) {
+        if (!installHandler(SIGINT, SignalHandler::signalHandler)) {
             qCritical() << "Failed to set up SIGINT handler.";
             return;
         }
 
-        struct sigaction sigterm = { };
-        sigterm.sa_handler = SignalHandler::termSignalHandler;
-        sigemptyset(&sigterm.sa_mask);
-        sigterm.sa_flags = SA_RESTART;
-
-        if (sigaction(SIGTERM, &sigterm, 0) > 0) {
+        if (!installHandler(SIGTERM, SignalHandler::signalHandler)) {
             qCritical() << "Failed to set up SIGTERM handler.";
             return;
         }
     }
 
     void SignalHandler::initializeSigusr1() {
-        struct sigaction sigusr1 = { };
-        sigusr1.sa_handler = SignalHandler::usr1SignalHandler;
-        sigemptyset(&sigusr1.sa_mask);
-        sigusr1.sa_flags = SA_RESTART;
-
-        if (sigaction(SIGUSR1, &sigusr1, 0) > 0) {
+        if (!installHandler(SIGUSR1, SignalHandler::signalHandler))
             qCritical() << "Failed to set up SIGUSR1 handler.";
-            return;
-        }
     }
 
     void SignalHandler::ignoreSigusr1() {
-        struct sigaction sigusr1 = { };
-        sigusr1.sa_handler = SIG_IGN;
-        sigemptyset(&sigusr1.sa_mask);
-        sigusr1.sa_flags = SA_RESTART;
-
-        if (sigaction(SIGUSR1, &sigusr1, 0) > 0) {
+        if (!installHandler(SIGUSR1, SIG_IGN))
             qCritical() << "Failed to set up SIGUSR1 handler.";
-            return;
-        }
-    }
-
-    void SignalHandler::hupSignalHandler(int) {
-        char a = 1;
-        if (::write(sighupFd[0], &a, sizeof(a)) == -1) {
-            qCritical() << "Error writing to the SIGHUP handler";
-            return;
-        }
     }
 
-    void SignalHandler::intSignalHandler(int) {
+    void SignalHandler::signalHandler(int signo) {
+        int savedErrno = errno;
+        pendingSignals[signo] = 1;
+        // a full socket already has a wakeup pending, dropping the byte is fine
         char a = 1;
-        if (::write(sigintFd[0], &a, sizeof(a)) == -1) {
-            qCritical() << "Error writing to the SIGINT handler";
-            return;
-        }
+        ssize_t written = ::write(signalFd[0], &a, sizeof(a));
+        Q_UNUSED(written);
+        errno = savedErrno;
     }
 
-    void SignalHandler::termSignalHandler(int) {
-        char a = 1;
-        if (::write(sigtermFd[0], &a, sizeof(a)) == -1) {
-            qCritical() << "Error writing to the SIGTERM handler";
-            return;
-        }
-    }
+    void SignalHandler::readSignals() {
+        // drain the wakeups first, signals arriving later send a new one
+        char buffer[64];
+        ssize_t count;
+        while ((count = ::read(signalFd[1], buffer, sizeof(buffer))) > 0)
+            ;
 
-    void SignalHandler::usr1SignalHandler(int) {
-        char a = 1;
-        if (::write(sigusr1Fd[0], &a, sizeof(a)) == -1) {
-            qCritical() << "Error writing to the SIGUSR1 handler";
-            return;
-        }
-    }
-
-    void SignalHandler::handleSighup() {
-        // disable notifier
-        snhup->setEnabled(false);
-
-        // read from socket
-        char a;
-        if (::read(sighupFd[1], &a, sizeof(a)) == -1) {
-            // something went wrong!
+        if (count == -1 && errno != EAGAIN && errno != EINTR)
             qCritical() << "Error reading from the socket";
-            return;
-        }
-
-        // log event
-        qWarning() << "Signal received: SIGHUP";
-
-        // emit signal
-        emit sighupReceived();
-
-        // enable notifier
-        snhup->setEnabled(true);
-    }
 
-    void SignalHandler::handleSigint() {
-        // disable notifier
-        snint->setEnabled(false);
-
-        // read from socket
-        char a;
-        if (::read(sigintFd[1], &a, sizeof(a)) == -1) {
-            // something went wrong!
-            qCritical() << "Error reading from the socket";
-            return;
+        if (pendingSignals[SIGHUP]) {
+            pendingSignals[SIGHUP] = 0;
+            qWarning() << "Signal received: SIGHUP";
+            emit sighupReceived();
         }
-
-        // log event
-        qWarning() << "Signal received: SIGINT";
-
-        // emit signal
-        emit sigintReceived();
-
-        // enable notifier
-        snint->setEnabled(true);
-    }
-
-    void SignalHandler::handleSigterm() {
-        // disable notifier
-        snterm->setEnabled(false);
-
-        // read from socket
-        char a;
-        if (::read(sigtermFd[1], &a, sizeof(a)) == -1) {
-            // something went wrong!
-            qCritical() << "Error reading from the socket";
-            return;
+        if (pendingSignals[SIGINT]) {
+            pendingSignals[SIGINT] = 0;
+            qWarning() << "Signal received: SIGINT";
+            emit sigintReceived();
         }
-
-        // log event
-        qWarning() << "Signal received: SIGTERM";
-
-        // emit signal
-        emit sigtermReceived();
-
-        // enable notifier
-        snterm->setEnabled(true);
-    }
-
-    void SignalHandler::handleSigusr1() {
-        // disable notifier
-        snusr1->setEnabled(false);
-
-        // read from socket
-        char a;
-        if (::read(sigusr1Fd[1], &a, sizeof(a)) == -1) {
-            // something went wrong!
-            qCritical() << "Error reading from the socket";
-            return;
+        if (pendingSignals[SIGTERM]) {
+            pendingSignals[SIGTERM] = 0;
+            qWarning() << "Signal received: SIGTERM";
+            emit sigtermReceived();
+        }
+        if (pendingSignals[SIGUSR1]) {
+            pendingSignals[SIGUSR1] = 0;
+            qWarning() << "Signal received: SIGUSR1";
+            emit sigusr1Received();
         }
-
-        // log event
-        qWarning() << "Signal received: SIGUSR1";
-
-        // emit signal
-        emit sigusr1Received();
-
-        // enable notifier
-        snusr1->setEnabled(true);
     }
 }
@@ -34,10 +34,7 @@ namespace SDDM {
         static void initialize();
         static void initializeSigusr1();
         static void ignoreSigusr1();
-        static void hupSignalHandler(int unused);
-        static void intSignalHandler(int unused);
-        static void termSignalHandler(int unused);
-        static void usr1SignalHandler(int unused);
+        static void signalHandler(int signo);
 
     signals:
         void sighupReceived();
@@ -46,16 +43,10 @@ namespace SDDM {
         void sigusr1Received();
 
     private slots:
-        void handleSighup();
-        void handleSigint();
-        void handleSigterm();
-        void handleSigusr1();
+        void readSignals();
 
     private:
-        QSocketNotifier *snhup { nullptr };
-        QSocketNotifier *snint { nullptr };
-        QSocketNotifier *snterm { nullptr };
-        QSocketNotifier *snusr1 { nullptr };
+        QSocketNotifier *m_notifier { nullptr };
     };
 }
 #endif // SDDM_SIGNALHANDLER_H
@@ -22,6 +22,7 @@
 
 #include "DaemonApp.h"
 #include "Messages.h"
+#include "Metrics.h"
 #include "PowerManager.h"
 #include "SocketWriter.h"
 #include "Utils.h"
@@ -30,6 +31,7 @@
 
 namespace SDDM {
     SocketServer::SocketServer(QObject *parent) : QObject(parent) {
+        connect(daemonApp->powerManager(), &PowerManager::actionFinished, this, &SocketServer::powerActionFinished);
     }
 
     QString SocketServer::socketAddress() const {
@@ -113,6 +115,8 @@ namespace SDDM {
         quint32 message;
         input >> message;
 
+        daemonApp->metrics()->increment(Metrics::SocketMessagesReceived);
+
         switch (GreeterMessages(message)) {
             case GreeterMessages::Connect: {
                 // log message
@@ -123,6 +127,7 @@ namespace SDDM {
 
                 // send host name
                 SocketWriter(socket) << quint32(DaemonMessages::HostName) << daemonApp->hostName();
+                daemonApp->metrics()->increment(Metrics::SocketMessagesSent, 2);
 
                 // emit signal
                 emit connected();
@@ -141,12 +146,23 @@ namespace SDDM {
                 emit login(socket, user, password, session);
             }
             break;
+            case GreeterMessages::SelectUser: {
+                // log message
+                qDebug() << "Message received from greeter: SelectUser";
+
+                QString user;
+                input >> user;
+
+                // emit signal
+                emit userSelected(user);
+            }
+            break;
             case GreeterMessages::PowerOff: {
                 // log message
                 qDebug() << "Message received from greeter: PowerOff";
 
                 // power off
-                daemonApp->powerManager()->powerOff();
+                m_powerRequests.insert(daemonApp->powerManager()->powerOff(), socket);
             }
             break;
             case GreeterMessages::Reboot: {
@@ -154,7 +170,7 @@ namespace SDDM {
                 qDebug() << "Message received from greeter: Reboot";
 
                 // reboot
-                daemonApp->powerManager()->reboot();
+                m_powerRequests.insert(daemonApp->powerManager()->reboot(), socket);
             }
             break;
             case GreeterMessages::Suspend: {
@@ -162,7 +178,7 @@ namespace SDDM {
                 qDebug() << "Message received from greeter: Suspend";
 
                 // suspend
-                daemonApp->powerManager()->suspend();
+                m_powerRequests.insert(daemonApp->powerManager()->suspend(), socket);
             }
             break;
             case GreeterMessages::Hibernate: {
@@ -170,7 +186,7 @@ namespace SDDM {
                 qDebug() << "Message received from greeter: Hibernate";
 
                 // hibernate
-                daemonApp->powerManager()->hibernate();
+                m_powerRequests.insert(daemonApp->powerManager()->hibernate(), socket);
             }
             break;
             case GreeterMessages::HybridSleep: {
@@ -178,7 +194,7 @@ namespace SDDM {
                 qDebug() << "Message received from greeter: HybridSleep";
 
                 // hybrid sleep
-                daemonApp->powerManager()->hybridSleep();
+                m_powerRequests.insert(daemonApp->powerManager()->hybridSleep(), socket);
             }
             break;
             default: {
@@ -190,9 +206,43 @@ namespace SDDM {
 
     void SocketServer::loginFailed(QLocalSocket *socket) {
         SocketWriter(socket) << quint32(DaemonMessages::LoginFailed);
+        daemonApp->metrics()->increment(Metrics::SocketMessagesSent);
     }
 
     void SocketServer::loginSucceeded(QLocalSocket *socket) {
         SocketWriter(socket) << quint32(DaemonMessages::LoginSucceeded);
+        daemonApp->metrics()->increment(Metrics::SocketMessagesSent);
+    }
+
+    void SocketServer::stayResident(QLocalSocket *socket) {
+        SocketWriter(socket) << quint32(DaemonMessages::StayResident);
+        daemonApp->metrics()->increment(Metrics::SocketMessagesSent);
+    }
+
+    void SocketServer::reset() {
+        if (!m_server)
+            return;
+
+        // connected greeters are children of the server
+        const auto sockets = m_server->findChildren<QLocalSocket *>();
+        for (QLocalSocket *socket : sockets) {
+            SocketWriter(socket) << quint32(DaemonMessages::Reset);
+            daemonApp->metrics()->increment(Metrics::SocketMessagesSent);
+        }
+    }
+
+    void SocketServer::powerActionFinished(quint32 request, quint32 action, bool success, const QString &error) {
+        // check if the request came from one of our greeters
+        if (!m_powerRequests.contains(request))
+            return;
+
+        QPointer<QLocalSocket> socket = m_powerRequests.take(request);
+
+        // the greeter may have gone away in the meantime
+        if (!socket)
+            return;
+
+        SocketWriter(socket) << quint32(DaemonMessages::PowerActionFinished) << action << quint32(success) << error;
+        daemonApp->metrics()->increment(Metrics::SocketMessagesSent);
     }
 }
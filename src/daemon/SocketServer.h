@@ -21,7 +21,9 @@
 #ifndef SDDM_SOCKETSERVER_H
 #define SDDM_SOCKETSERVER_H
 
+#include <QHash>
 #include <QObject>
+#include <QPointer>
 #include <QString>
 
 #include "Session.h"
@@ -41,21 +43,31 @@ namespace SDDM {
 
         QString socketAddress() const;
 
+        // asks resident greeters to reset and show themselves again
+        void reset();
+
     private slots:
         void newConnection();
         void readyRead();
 
         void loginFailed(QLocalSocket *socket);
         void loginSucceeded(QLocalSocket *socket);
+        void stayResident(QLocalSocket *socket);
+
+        void powerActionFinished(quint32 request, quint32 action, bool success, const QString &error);
 
     signals:
         void login(QLocalSocket *socket,
                    const QString &user, const QString &password,
                    const Session &session);
         void connected();
+        void userSelected(const QString &user);
 
     private:
         QLocalServer *m_server { nullptr };
+
+        // pending power actions and the greeter that requested them
+        QHash<quint32, QPointer<QLocalSocket>> m_powerRequests;
     };
 }
 
@@ -21,8 +21,12 @@
 #ifndef SDDM_UTILS_H
 #define SDDM_UTILS_H
 
+#include <QFile>
+
 #include <random>
 
+#include <unistd.h>
+
 namespace SDDM {
 
 inline QString generateName(int length) {
@@ -44,6 +48,19 @@ inline QString generateName(int length) {
     // return result
     return name;
 }
+
+// resident set size of the daemon, in bytes
+inline qint64 residentSetSize() {
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+
+    // second field, in pages
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return 0;
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+}
 }
 
 #endif
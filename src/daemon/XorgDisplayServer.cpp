@@ -23,9 +23,13 @@
 #include "Configuration.h"
 #include "DaemonApp.h"
 #include "Display.h"
+#include "GreeterSnapshot.h"
+#include "Metrics.h"
 #include "SignalHandler.h"
 #include "Seat.h"
+#include "SeatResources.h"
 
+#include <QDataStream>
 #include <QDebug>
 #include <QFile>
 #include <QDir>
@@ -37,10 +41,15 @@
 #include <xcb/xcb.h>
 
 #include <pwd.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 namespace SDDM {
     XorgDisplayServer::XorgDisplayServer(Display *parent) : DisplayServer(parent) {
+    }
+
+    void XorgDisplayServer::generateAuthority() {
         // get auth directory
         QString authDir = QStringLiteral(RUNTIME_DIR);
 
@@ -88,29 +97,31 @@ namespace SDDM {
         return m_cookie;
     }
 
-    bool XorgDisplayServer::addCookie(const QString &file) {
+    bool XorgDisplayServer::writeCookie(const QString &file) {
         // log message
-        qDebug() << "Adding cookie to" << file;
-
-        // Touch file
-        QFile file_handler(file);
-        file_handler.open(QIODevice::Append);
-        file_handler.close();
-
-        QString cmd = QStringLiteral("%1 -f %2 -q").arg(mainConfig.X11.XauthPath.get()).arg(file);
+        qDebug() << "Writing cookie to" << file;
 
-        // execute xauth
-        FILE *fp = popen(qPrintable(cmd), "w");
-
-        // check file
-        if (!fp)
+        QFile authFile(file);
+        if (!authFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
             return false;
-        fprintf(fp, "remove %s\n", qPrintable(m_display));
-        fprintf(fp, "add %s . %s\n", qPrintable(m_display), qPrintable(m_cookie));
-        fprintf(fp, "exit\n");
-
-        // close pipe
-        return pclose(fp) == 0;
+        authFile.setPermissions(QFile::ReadOwner | QFile::WriteOwner);
+
+        // A single FamilyWild entry matches any display number, so the file
+        // is valid for the server as well as for the greeter and only needs
+        // to be written once, before we know which display we got.
+        // Every field but the family is prefixed by its length, all big endian.
+        QDataStream out(&authFile);
+        auto writeField = [&out](const QByteArray &data) {
+            out << quint16(data.size());
+            out.writeRawData(data.constData(), data.size());
+        };
+        out << quint16(0xffff);
+        writeField(QByteArray());
+        writeField(QByteArray());
+        writeField(QByteArrayLiteral("MIT-MAGIC-COOKIE-1"));
+        writeField(QByteArray::fromHex(m_cookie.toLatin1()));
+
+        return out.status() == QDataStream::Ok && authFile.flush();
     }
 
     bool XorgDisplayServer::start() {
@@ -118,6 +129,11 @@ namespace SDDM {
         if (m_started)
             return false;
 
+        m_startTimer.start();
+
+        // the auth file and cookie are only needed once the server starts
+        generateAuthority();
+
         // create process
         process = new QProcess(this);
 
@@ -128,10 +144,9 @@ namespace SDDM {
         qDebug() << "Display server starting...";
 
         // generate auth file.
-        // For the X server's copy, the display number doesn't matter.
         // An empty file would result in no access control!
         m_display = QStringLiteral(":0");
-        if(!addCookie(m_authPath)) {
+        if(!writeCookie(m_authPath)) {
             qCritical() << "Failed to write xauth file";
             return false;
         }
@@ -156,6 +171,10 @@ namespace SDDM {
                 // return fail
                 return false;
             }
+            SeatResources::attach(displayPtr()->seat()->name(), process->processId());
+            daemonApp->metrics()->increment(Metrics::DisplayServerStarted);
+            daemonApp->metrics()->record(Metrics::DisplayServerStartTime, m_startTimer.elapsed());
+
             emit started();
         } else {
             // set process environment
@@ -196,6 +215,8 @@ namespace SDDM {
                 return false;
             }
 
+            SeatResources::attach(displayPtr()->seat()->name(), process->processId());
+
             // close the other side of pipe in our process, otherwise reading
             // from it may stuck even X server exit.
             close(pipeFds[1]);
@@ -223,17 +244,13 @@ namespace SDDM {
             // close our pipe
             close(pipeFds[0]);
 
+            daemonApp->metrics()->increment(Metrics::DisplayServerStarted);
+            daemonApp->metrics()->record(Metrics::DisplayServerStartTime, m_startTimer.elapsed());
+
             emit started();
         }
 
-        // The file is also used by the greeter, which does care about the
-        // display number. Write the proper entry, if it's different.
-        if(m_display != QStringLiteral(":0")) {
-            if(!addCookie(m_authPath)) {
-                qCritical() << "Failed to write xauth file";
-                return false;
-            }
-        }
+        // the greeter reads the file as well
         changeOwner(m_authPath);
 
         // set flag
@@ -286,6 +303,7 @@ namespace SDDM {
         // start display stop script
         qDebug() << "Running display stop script " << displayStopCommand;
         displayStopScript->start(displayStopCommand);
+        SeatResources::attach(displayPtr()->seat()->name(), displayStopScript->processId());
 
         // wait for finished
         if (!displayStopScript->waitForFinished(5000))
@@ -306,6 +324,100 @@ namespace SDDM {
         emit stopped();
     }
 
+    void XorgDisplayServer::showSnapshot(const QString &themePath) {
+        const QByteArray cookie = QByteArray::fromHex(m_cookie.toLatin1());
+        xcb_auth_info_t auth;
+        auth.name = const_cast<char *>("MIT-MAGIC-COOKIE-1");
+        auth.namelen = 18;
+        auth.data = const_cast<char *>(cookie.constData());
+        auth.datalen = cookie.size();
+
+        int screenNumber = 0;
+        xcb_connection_t *connection = xcb_connect_to_display_with_auth_info(qPrintable(m_display), &auth, &screenNumber);
+        if (xcb_connection_has_error(connection)) {
+            xcb_disconnect(connection);
+            return;
+        }
+
+        const xcb_setup_t *setup = xcb_get_setup(connection);
+        xcb_screen_iterator_t screens = xcb_setup_roots_iterator(setup);
+        for (int i = 0; i < screenNumber && screens.rem; ++i)
+            xcb_screen_next(&screens);
+        xcb_screen_t *screen = screens.data;
+
+        // snapshots are stored as 32 bit pixels in host byte order
+        bool supported = screen && screen->root_depth == 24;
+        supported &= setup->image_byte_order == (Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? XCB_IMAGE_ORDER_LSB_FIRST : XCB_IMAGE_ORDER_MSB_FIRST);
+        bool bpp32 = false;
+        for (auto formats = xcb_setup_pixmap_formats_iterator(setup); formats.rem; xcb_format_next(&formats))
+            bpp32 |= formats.data->depth == 24 && formats.data->bits_per_pixel == 32;
+
+        const QDir dir(GreeterSnapshot::directory(themePath, supported ? screen->width_in_pixels : 0,
+                                                  supported ? screen->height_in_pixels : 0));
+        const QStringList files = dir.entryList({ QStringLiteral("*.raw") }, QDir::Files);
+        if (!supported || !bpp32 || files.isEmpty()) {
+            xcb_disconnect(connection);
+            return;
+        }
+
+        const quint16 rootWidth = screen->width_in_pixels;
+        const quint16 rootHeight = screen->height_in_pixels;
+        xcb_pixmap_t pixmap = xcb_generate_id(connection);
+        xcb_create_pixmap(connection, 24, pixmap, screen->root, rootWidth, rootHeight);
+        xcb_gcontext_t gc = xcb_generate_id(connection);
+        const quint32 black = screen->black_pixel;
+        xcb_create_gc(connection, gc, pixmap, XCB_GC_FOREGROUND, &black);
+        const xcb_rectangle_t all { 0, 0, rootWidth, rootHeight };
+        xcb_poly_fill_rectangle(connection, pixmap, gc, 1, &all);
+
+        // leave room for the PutImage request header
+        const quint32 maxRequest = xcb_get_maximum_request_length(connection) * 4 - 64;
+
+        for (const QString &name : files) {
+            const QStringList position = name.section(QLatin1Char('.'), 0, 0).split(QLatin1Char('_'));
+            if (position.size() != 2)
+                continue;
+            const int x = position.at(0).toInt();
+            const int y = position.at(1).toInt();
+
+            QFile file(dir.filePath(name));
+            if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(GreeterSnapshot::Header)))
+                continue;
+            const uchar *data = file.map(0, file.size());
+            if (!data)
+                continue;
+
+            GreeterSnapshot::Header header;
+            memcpy(&header, data, sizeof(header));
+            const qint64 stride = qint64(header.width) * 4;
+            if (header.magic != GreeterSnapshot::Magic || header.width == 0 || header.height == 0 ||
+                    file.size() < qint64(sizeof(header)) + stride * header.height ||
+                    x < 0 || y < 0 || x + header.width > rootWidth || y + header.height > rootHeight ||
+                    stride > maxRequest)
+                continue;
+
+            // split the image in as many rows as fit in one request
+            const quint32 rowsPerRequest = maxRequest / stride;
+            const uchar *pixels = data + sizeof(header);
+            for (quint32 row = 0; row < header.height; row += rowsPerRequest) {
+                const quint32 rows = qMin(rowsPerRequest, header.height - row);
+                xcb_put_image(connection, XCB_IMAGE_FORMAT_Z_PIXMAP, pixmap, gc,
+                              header.width, rows, x, y + row, 0, 24,
+                              rows * stride, pixels + row * stride);
+            }
+        }
+
+        // the root window keeps the pixmap after we free our handle, like xsetroot does
+        xcb_change_window_attributes(connection, screen->root, XCB_CW_BACK_PIXMAP, &pixmap);
+        xcb_clear_area(connection, 0, screen->root, 0, 0, 0, 0);
+        xcb_free_gc(connection, gc);
+        xcb_free_pixmap(connection, pixmap);
+        free(xcb_get_input_focus_reply(connection, xcb_get_input_focus(connection), nullptr));
+        xcb_disconnect(connection);
+
+        qDebug() << "Painted greeter snapshot from" << dir.path();
+    }
+
     void XorgDisplayServer::setupDisplay() {
         QString displayCommand = mainConfig.X11.DisplayCommand.get();
 
@@ -327,6 +439,7 @@ namespace SDDM {
 
         qDebug() << "Setting default cursor";
         setCursor->start(QStringLiteral("xsetroot -cursor_name left_ptr"));
+        SeatResources::attach(displayPtr()->seat()->name(), setCursor->processId());
 
         // delete setCursor on finish
         connect(setCursor, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), setCursor, &QProcess::deleteLater);
@@ -340,6 +453,7 @@ namespace SDDM {
         // start display setup script
         qDebug() << "Running display setup script " << displayCommand;
         displayScript->start(displayCommand);
+        SeatResources::attach(displayPtr()->seat()->name(), displayScript->processId());
 
         // delete displayScript on finish
         connect(displayScript, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), displayScript, &QProcess::deleteLater);
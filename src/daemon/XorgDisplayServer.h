@@ -23,6 +23,8 @@
 
 #include "DisplayServer.h"
 
+#include <QElapsedTimer>
+
 class QProcess;
 
 namespace SDDM {
@@ -40,7 +42,10 @@ namespace SDDM {
 
         const QString &cookie() const;
 
-        bool addCookie(const QString &file);
+        bool writeCookie(const QString &file);
+
+        // paints the last greeter frame of the theme on the root window
+        void showSnapshot(const QString &themePath);
 
     public slots:
         bool start();
@@ -54,6 +59,9 @@ namespace SDDM {
 
         QProcess *process { nullptr };
 
+        QElapsedTimer m_startTimer;
+
+        void generateAuthority();
         void changeOwner(const QString &fileName);
     };
 }
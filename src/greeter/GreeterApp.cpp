@@ -21,6 +21,7 @@
 #include "GreeterApp.h"
 #include "Configuration.h"
 #include "GreeterProxy.h"
+#include "GreeterSnapshot.h"
 #include "Constants.h"
 #include "ScreenModel.h"
 #include "SessionModel.h"
@@ -38,6 +39,10 @@
 #include <QQmlContext>
 #include <QQmlEngine>
 #include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSharedPointer>
 #include <QTimer>
 #include <QTranslator>
 #include <QLibraryInfo>
@@ -46,6 +51,8 @@
 
 #include <iostream>
 
+#include <xcb/xcb.h>
+
 #define TR(x) QT_TRANSLATE_NOOP("Command line parser", QStringLiteral(x))
 
 static const QEvent::Type StartupEventType = static_cast<QEvent::Type>(QEvent::registerEventType());
@@ -114,8 +121,8 @@ namespace SDDM {
             m_themeConfig = new ThemeConfig(configFile);
 
         const bool themeNeedsAllUsers = m_themeConfig->value(QStringLiteral("needsFullUserModel"), true).toBool();
-        if(m_userModel && themeNeedsAllUsers && !m_userModel->containsAllUsers()) {
-            // The theme needs all users, but the current user model doesn't have them -> recreate
+        if(m_userModel && themeNeedsAllUsers && !m_userModel->needsAllUsers()) {
+            // The theme needs all users, but the current user model won't have them -> recreate
             m_userModel->deleteLater();
             m_userModel = nullptr;
         }
@@ -167,8 +174,14 @@ namespace SDDM {
 
         view->engine()->addImportPath(QStringLiteral(IMPORTS_INSTALL_DIR));
 
-        // connect proxy signals
-        connect(m_proxy, &GreeterProxy::loginSucceeded, view, &QQuickView::close);
+        // connect proxy signals, a resident greeter only hides until the daemon resets it
+        connect(m_proxy, &GreeterProxy::loginSucceeded, view, [this, view] {
+            if (m_proxy->isResident())
+                view->hide();
+            else
+                view->close();
+        });
+        connect(m_proxy, &GreeterProxy::reset, view, &QQuickView::show);
 
         // we used to have only one window as big as the virtual desktop,
         // QML took care of creating an item for each screen by iterating on
@@ -231,11 +244,96 @@ namespace SDDM {
         // activate windows for the primary screen to give focus to text fields
         if (QGuiApplication::primaryScreen() == screen)
             view->requestActivate();
+
+        // the first frame of the loaded theme is what the snapshot shows,
+        // it is taken before the user had a chance to type anything
+        m_unpaintedViews.insert(view);
+        QSharedPointer<QMetaObject::Connection> firstFrame(new QMetaObject::Connection);
+        *firstFrame = connect(view, &QQuickWindow::frameSwapped, this, [this, view, firstFrame] {
+            if (view->status() != QQuickView::Ready)
+                return;
+            disconnect(*firstFrame);
+
+            saveSnapshot(view);
+
+            m_unpaintedViews.remove(view);
+            if (m_unpaintedViews.isEmpty())
+                clearSnapshot();
+        });
+    }
+
+    QString GreeterApp::snapshotDirectory(QScreen *screen) const {
+        // sizes are in device pixels, like the root window the daemon paints on
+        const qreal ratio = screen->devicePixelRatio();
+        const QRect root = screen->virtualGeometry();
+        const QString themePath = m_themePath.startsWith(QLatin1String("qrc:/")) ? QString() : m_themePath;
+        return GreeterSnapshot::directory(themePath, qRound(root.width() * ratio), qRound(root.height() * ratio));
+    }
+
+    void GreeterApp::saveSnapshot(QQuickView *view) {
+        if (m_testing || !view->isVisible())
+            return;
+
+        QScreen *screen = view->screen();
+        const QPoint position = (screen->geometry().topLeft() - screen->virtualGeometry().topLeft()) * screen->devicePixelRatio();
+        const QString dirPath = snapshotDirectory(screen);
+        const QString path = QStringLiteral("%1/%2").arg(dirPath, GreeterSnapshot::fileName(position.x(), position.y()));
+        if (QFileInfo::exists(path))
+            return;
+
+        const QImage image = view->grabWindow().convertToFormat(QImage::Format_RGB32);
+        if (image.isNull())
+            return;
+
+        // snapshots of older theme versions are never shown again
+        QDir snapshots(QStringLiteral(STATE_DIR "/snapshots"));
+        const QString version = QFileInfo(QFileInfo(dirPath).path()).fileName();
+        const auto entries = snapshots.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        for (const QString &entry : entries) {
+            if (entry != version)
+                QDir(snapshots.filePath(entry)).removeRecursively();
+        }
+
+        if (!QDir().mkpath(dirPath))
+            return;
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+            return;
+        const GreeterSnapshot::Header header { GreeterSnapshot::Magic, quint32(image.width()), quint32(image.height()) };
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        for (int y = 0; y < image.height(); ++y)
+            file.write(reinterpret_cast<const char *>(image.constScanLine(y)), image.width() * 4);
+        if (file.commit())
+            qDebug() << "Saved greeter snapshot" << path;
+    }
+
+    void GreeterApp::clearSnapshot() {
+        // every view covers its part of the root window now, drop the
+        // snapshot so that it neither shows up in an X11 session nor keeps
+        // its pixmap in the server
+        if (!m_snapshotShown || QGuiApplication::platformName() != QLatin1String("xcb"))
+            return;
+        m_snapshotShown = false;
+
+        xcb_connection_t *connection = xcb_connect(nullptr, nullptr);
+        if (!xcb_connection_has_error(connection)) {
+            const quint32 none = XCB_BACK_PIXMAP_NONE;
+            for (auto screens = xcb_setup_roots_iterator(xcb_get_setup(connection)); screens.rem; xcb_screen_next(&screens)) {
+                xcb_change_window_attributes(connection, screens.data->root, XCB_CW_BACK_PIXMAP, &none);
+                xcb_clear_area(connection, 0, screens.data->root, 0, 0, 0, 0);
+            }
+            xcb_flush(connection);
+        }
+        xcb_disconnect(connection);
     }
 
     void GreeterApp::removeViewForScreen(QQuickView *view) {
         // screen is gone, remove the window
         m_views.removeOne(view);
+        m_unpaintedViews.remove(view);
+        if (m_unpaintedViews.isEmpty())
+            clearSnapshot();
         view->deleteLater();
     }
 
@@ -266,16 +364,26 @@ namespace SDDM {
         // Set session model on proxy
         m_proxy->setSessionModel(m_sessionModel);
 
+        // the daemon paints the snapshot on the root window when there is one
+        m_snapshotShown = !m_testing && QDir(snapshotDirectory(qGuiApp->primaryScreen())).exists();
+
         // Create views
         const QList<QScreen *> screens = qGuiApp->primaryScreen()->virtualSiblings();
         for (QScreen *screen : screens)
             addViewForScreen(screen);
 
+        // themes that only show the last user never trigger the enumeration
+        if (!m_userModel->isPopulated())
+            qDebug() << "Theme did not request the user list, users were not enumerated";
+
         // Handle screens
         connect(qGuiApp, &QGuiApplication::screenAdded, this, &GreeterApp::addViewForScreen);
         connect(qGuiApp, &QGuiApplication::primaryScreenChanged, this, [this](QScreen *) {
             activatePrimary();
         });
+
+        // the views are shown again by now, give focus back to the primary one
+        connect(m_proxy, &GreeterProxy::reset, this, &GreeterApp::activatePrimary);
     }
 
     void GreeterApp::activatePrimary() {
@@ -23,6 +23,7 @@
 
 #include <QObject>
 #include <QScreen>
+#include <QSet>
 #include <QQuickView>
 
 class QTranslator;
@@ -67,6 +68,10 @@ namespace SDDM {
         QString m_themePath;
 
         QList<QQuickView *> m_views;
+        // views that have not shown their first frame yet
+        QSet<QQuickView *> m_unpaintedViews;
+        // the daemon painted a snapshot on the root window
+        bool m_snapshotShown { false };
         QTranslator *m_theme_translator { nullptr },
                     *m_components_tranlator { nullptr };
 
@@ -79,6 +84,9 @@ namespace SDDM {
 
         void startup();
         void activatePrimary();
+        QString snapshotDirectory(QScreen *screen) const;
+        void saveSnapshot(QQuickView *view);
+        void clearSnapshot();
     };
 
     class StartupEvent : public QEvent
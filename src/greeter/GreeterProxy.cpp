@@ -26,20 +26,41 @@
 #include "SocketWriter.h"
 
 #include <QLocalSocket>
+#include <QTimer>
 
 namespace SDDM {
     class GreeterProxyPrivate {
     public:
         SessionModel *sessionModel { nullptr };
         QLocalSocket *socket { nullptr };
+        QTimer *selectTimer { nullptr };
+        QString selectedUser;
         QString hostName;
         bool canPowerOff { false };
         bool canReboot { false };
         bool canSuspend { false };
         bool canHibernate { false };
         bool canHybridSleep { false };
+        bool resident { false };
     };
 
+    static QString powerActionName(quint32 action) {
+        switch (action) {
+        case Capability::PowerOff:
+            return QStringLiteral("powerOff");
+        case Capability::Reboot:
+            return QStringLiteral("reboot");
+        case Capability::Suspend:
+            return QStringLiteral("suspend");
+        case Capability::Hibernate:
+            return QStringLiteral("hibernate");
+        case Capability::HybridSleep:
+            return QStringLiteral("hybridSleep");
+        default:
+            return QString();
+        }
+    }
+
     GreeterProxy::GreeterProxy(const QString &socket, QObject *parent) : QObject(parent), d(new GreeterProxyPrivate()) {
         d->socket = new QLocalSocket(this);
         // connect signals
@@ -48,6 +69,12 @@ namespace SDDM {
         connect(d->socket, &QLocalSocket::readyRead, this, &GreeterProxy::readyRead);
         connect(d->socket, QOverload<QLocalSocket::LocalSocketError>::of(&QLocalSocket::error), this, &GreeterProxy::error);
 
+        // don't bother the daemon with every key stroke of a typed user name
+        d->selectTimer = new QTimer(this);
+        d->selectTimer->setSingleShot(true);
+        d->selectTimer->setInterval(400);
+        connect(d->selectTimer, &QTimer::timeout, this, &GreeterProxy::sendSelectedUser);
+
         // connect to server
         d->socket->connectToServer(socket);
     }
@@ -88,6 +115,10 @@ namespace SDDM {
         return d->socket->state() == QLocalSocket::ConnectedState;
     }
 
+    bool GreeterProxy::isResident() const {
+        return d->resident;
+    }
+
     void GreeterProxy::powerOff() {
         SocketWriter(d->socket) << quint32(GreeterMessages::PowerOff);
     }
@@ -124,9 +155,24 @@ namespace SDDM {
         Session::Type type = static_cast<Session::Type>(d->sessionModel->data(index, SessionModel::TypeRole).toInt());
         QString name = d->sessionModel->data(index, SessionModel::FileRole).toString();
         Session session(type, name);
+
+        // the selection is outdated once the login is on its way
+        d->selectTimer->stop();
         SocketWriter(d->socket) << quint32(GreeterMessages::Login) << user << password << session;
     }
 
+    void GreeterProxy::selectUser(const QString &user) {
+        d->selectedUser = user;
+        d->selectTimer->start();
+    }
+
+    void GreeterProxy::sendSelectedUser() {
+        if (d->selectedUser.isEmpty())
+            return;
+
+        SocketWriter(d->socket) << quint32(GreeterMessages::SelectUser) << d->selectedUser;
+    }
+
     void GreeterProxy::connected() {
         // log connection
         qDebug() << "Connected to the daemon.";
@@ -196,6 +242,24 @@ namespace SDDM {
                     emit loginSucceeded();
                 }
                 break;
+                case DaemonMessages::StayResident: {
+                    // log message
+                    qDebug() << "Message received from daemon: StayResident";
+
+                    // hide on the next login instead of quitting
+                    d->resident = true;
+                }
+                break;
+                case DaemonMessages::Reset: {
+                    // log message
+                    qDebug() << "Message received from daemon: Reset";
+
+                    d->resident = false;
+
+                    // emit signal
+                    emit reset();
+                }
+                break;
                 case DaemonMessages::LoginFailed: {
                     // log message
                     qDebug() << "Message received from daemon: LoginFailed";
@@ -204,6 +268,19 @@ namespace SDDM {
                     emit loginFailed();
                 }
                 break;
+                case DaemonMessages::PowerActionFinished: {
+                    // log message
+                    qDebug() << "Message received from daemon: PowerActionFinished";
+
+                    // read result
+                    quint32 action, success;
+                    QString error;
+                    input >> action >> success >> error;
+
+                    // emit signal
+                    emit powerActionFinished(powerActionName(action), success != 0, error);
+                }
+                break;
                 default: {
                     // log message
                     qWarning() << "Unknown message received from daemon.";
@@ -53,6 +53,9 @@ namespace SDDM {
 
         bool isConnected() const;
 
+        // true when the greeter hides after login instead of quitting
+        bool isResident() const;
+
         void setSessionModel(SessionModel *model);
 
     public slots:
@@ -64,11 +67,15 @@ namespace SDDM {
 
         void login(const QString &user, const QString &password, const int sessionIndex) const;
 
+        // lets the daemon prepare the authentication of a likely user
+        void selectUser(const QString &user);
+
     private slots:
         void connected();
         void disconnected();
         void readyRead();
         void error();
+        void sendSelectedUser();
 
     signals:
         void hostNameChanged(const QString &hostName);
@@ -80,6 +87,9 @@ namespace SDDM {
 
         void loginFailed();
         void loginSucceeded();
+        void reset();
+
+        void powerActionFinished(const QString &action, bool success, const QString &error);
 
     private:
         GreeterProxyPrivate *d { nullptr };
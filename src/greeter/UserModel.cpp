@@ -22,6 +22,7 @@
 #include "Constants.h"
 #include "Configuration.h"
 
+#include <QDebug>
 #include <QFile>
 #include <QList>
 #include <QTextStream>
@@ -61,9 +62,20 @@ namespace SDDM {
         int lastIndex { 0 };
         QList<UserPtr> users;
         bool containsAllUsers { true };
+        bool needAllUsers { true };
+        bool populated { false };
     };
 
     UserModel::UserModel(bool needAllUsers, QObject *parent) : QAbstractListModel(parent), d(new UserModelPrivate()) {
+        d->needAllUsers = needAllUsers;
+    }
+
+    void UserModel::populate() const {
+        if (d->populated)
+            return;
+        d->populated = true;
+
+        const bool needAllUsers = d->needAllUsers;
         const QString facesDir = mainConfig.Theme.FacesDir.get();
         const QString themeDir = mainConfig.Theme.ThemeDir.get();
         const QString currentTheme = mainConfig.Theme.Current.get();
@@ -146,6 +158,9 @@ namespace SDDM {
                     user->icon = QStringLiteral("file://%1").arg(systemFace);
             }
         }
+
+        qDebug() << "Theme requested the user list, enumerated" << d->users.count()
+                 << (d->containsAllUsers ? "users" : "users (partial list)");
     }
 
     UserModel::~UserModel() {
@@ -165,6 +180,7 @@ namespace SDDM {
     }
 
     const int UserModel::lastIndex() const {
+        populate();
         return d->lastIndex;
     }
 
@@ -173,10 +189,12 @@ namespace SDDM {
     }
 
     int UserModel::rowCount(const QModelIndex &parent) const {
+        populate();
         return d->users.length();
     }
 
     QVariant UserModel::data(const QModelIndex &index, int role) const {
+        populate();
         if (index.row() < 0 || index.row() > d->users.count())
             return QVariant();
 
@@ -204,6 +222,15 @@ namespace SDDM {
     }
 
     bool UserModel::containsAllUsers() const {
+        populate();
         return d->containsAllUsers;
     }
+
+    bool UserModel::needsAllUsers() const {
+        return d->needAllUsers;
+    }
+
+    bool UserModel::isPopulated() const {
+        return d->populated;
+    }
 }
@@ -57,7 +57,14 @@ namespace SDDM {
 
         int disableAvatarsThreshold() const;
         bool containsAllUsers() const;
+
+        // whether the model was asked for all users on construction
+        bool needsAllUsers() const;
+        // users are only enumerated once a view asks for them
+        bool isPopulated() const;
     private:
+        void populate() const;
+
         UserModelPrivate *d { nullptr };
     };
 }
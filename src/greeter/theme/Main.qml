@@ -85,6 +85,7 @@ Rectangle {
                 state: (listView.currentIndex === index) ? "active" : ""
 
                 onLogin: sddm.login(model.name, password, sessionIndex);
+                onFocusChanged: if (focus) sddm.selectUser(model.name);
 
                 MouseArea {
                     anchors.fill: parent
@@ -68,6 +68,9 @@ namespace SDDM {
             env.insert(QStringLiteral("SHELL"), QString::fromLocal8Bit(pw->pw_shell));
             env.insert(QStringLiteral("USER"), QString::fromLocal8Bit(pw->pw_name));
             env.insert(QStringLiteral("LOGNAME"), QString::fromLocal8Bit(pw->pw_name));
+            // read by the session scripts
+            if (!m_greeter && mainConfig.Users.CacheLoginEnvironment.get())
+                env.insert(QStringLiteral("SDDM_CACHE_LOGIN_ENV"), QStringLiteral("1"));
             if (env.contains(QStringLiteral("DISPLAY")) && !env.contains(QStringLiteral("XAUTHORITY"))) {
                 // determine Xauthority path
                 QString value = QStringLiteral("%1/%2")
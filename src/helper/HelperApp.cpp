@@ -210,14 +210,32 @@ namespace SDDM {
         m_socket->waitForBytesWritten();
     }
 
+    Msg HelperApp::receive(SafeDataStream &str) {
+        Msg m = Msg::MSG_UNKNOWN;
+        str.receive();
+        str >> m;
+
+        // the environment may arrive before any other message, keep it for later
+        if (m == ENVIRONMENT) {
+            QString session;
+            str >> m_environment >> m_cookie >> session;
+            if (!session.isEmpty())
+                m_session->setPath(session);
+            m_environmentReceived = true;
+        }
+        return m;
+    }
+
     Request HelperApp::request(const Request& request) {
         Msg m = Msg::MSG_UNKNOWN;
         Request response;
         SafeDataStream str(m_socket);
         str << Msg::REQUEST << request;
         str.send();
-        str.receive();
-        str >> m >> response;
+        do {
+            m = receive(str);
+        } while (m == ENVIRONMENT);
+        str >> response;
         if (m != REQUEST) {
             response = Request();
             qCritical() << "Received a wrong opcode instead of REQUEST:" << m;
@@ -226,33 +244,30 @@ namespace SDDM {
     }
 
     QProcessEnvironment HelperApp::authenticated(const QString &user) {
-        Msg m = Msg::MSG_UNKNOWN;
-        QProcessEnvironment env;
         SafeDataStream str(m_socket);
         str << Msg::AUTHENTICATED << user;
         str.send();
         if (user.isEmpty())
-            return env;
-        str.receive();
-        str >> m >> env >> m_cookie;
-        if (m != AUTHENTICATED) {
-            env = QProcessEnvironment();
+            return QProcessEnvironment();
+
+        // only wait if the daemon held the environment back
+        if (!m_environmentReceived) {
+            Msg m = receive(str);
+            if (m != ENVIRONMENT)
+                qCritical() << "Received a wrong opcode instead of ENVIRONMENT:" << m;
+        }
+        if (!m_environmentReceived) {
             m_cookie = QString();
-            qCritical() << "Received a wrong opcode instead of AUTHENTICATED:" << m;
+            return QProcessEnvironment();
         }
-        return env;
+        return m_environment;
     }
 
     void HelperApp::sessionOpened(bool success) {
-        Msg m = Msg::MSG_UNKNOWN;
+        // the daemon doesn't acknowledge this, nothing here depends on its answer
         SafeDataStream str(m_socket);
         str << Msg::SESSION_STATUS << success;
         str.send();
-        str.receive();
-        str >> m;
-        if (m != SESSION_STATUS) {
-            qCritical() << "Received a wrong opcode instead of SESSION_STATUS:" << m;
-        }
     }
 
     UserSession *HelperApp::session() {
@@ -25,6 +25,7 @@
 #include <QtCore/QProcessEnvironment>
 
 #include "AuthMessages.h"
+#include "SafeDataStream.h"
 
 class QLocalSocket;
 
@@ -63,6 +64,11 @@ namespace SDDM {
         QString m_user { };
         // TODO: get rid of this in a nice clean way along the way with moving to user session X server
         QString m_cookie { };
+        // sent by the daemon whenever it is complete, usually right after HELLO
+        QProcessEnvironment m_environment { };
+        bool m_environmentReceived { false };
+
+        Msg receive(SafeDataStream &str);
 
         /*!
          \brief Write utmp/wtmp/btmp records when a user logs in
@@ -22,11 +22,14 @@
 
 #include <QtCore/QDebug>
 
+#include <string.h>
+
 namespace SDDM {
     bool PamHandle::putEnv(const QProcessEnvironment& env) {
-        const auto envs = env.toStringList();
-        for (const QString& s : envs) {
-            m_result = pam_putenv(m_handle, qPrintable(s));
+        const QStringList keys = env.keys();
+        for (const QString &key : keys) {
+            const QByteArray entry = key.toUtf8() + '=' + env.value(key).toUtf8();
+            m_result = pam_putenv(m_handle, entry.constData());
             if (m_result != PAM_SUCCESS) {
                 qWarning() << "[PAM] putEnv:" << pam_strerror(m_handle, m_result);
                 return false;
@@ -46,14 +49,13 @@ namespace SDDM {
 
         // copy it to the env map
         for (int i = 0; envlist[i] != nullptr; ++i) {
-            QString s = QString::fromLocal8Bit(envlist[i]);
-
             // find equal sign
-            int index = s.indexOf(QLatin1Char('='));
+            const char *separator = strchr(envlist[i], '=');
 
-            // add to the hash
-            if (index != -1)
-                env.insert(s.left(index), s.mid(index + 1));
+            // add to the hash, converting key and value straight from the PAM buffer
+            if (separator != nullptr)
+                env.insert(QString::fromUtf8(envlist[i], int(separator - envlist[i])),
+                           QString::fromUtf8(separator + 1));
 
             free(envlist[i]);
         }
@@ -0,0 +1,188 @@
+/*
+ * Micro-benchmarks of parsing and serialization hot paths
+ * Copyright (C) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "AuthMessages.h"
+#include "Configuration.h"
+#include "SafeDataStream.h"
+#include "Session.h"
+#include "SessionModel.h"
+#include "UserModel.h"
+
+#include <QtTest/QtTest>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtNetwork/QLocalSocket>
+
+#include <sys/socket.h>
+
+using namespace SDDM;
+
+QTEST_GUILESS_MAIN(Benchmark);
+
+static const int SESSION_COUNT = 50;
+
+void Benchmark::initTestCase() {
+    // a configuration file with some unknown entries, like a real one
+    QFile::remove(BENCH_CONF_FILE);
+    QFile file(BENCH_CONF_FILE);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream conf(&file);
+    conf << "String=Value\nInt=7\nStringList=a,b,c,d\n";
+    conf << "[First]\nString=Value\nBoolean=false\n";
+    conf << "[Second]\nString=Value\nInt=7\n";
+    for (int i = 0; i < 20; ++i)
+        conf << "[Unused" << i << "]\nKey=Value\n";
+    file.close();
+
+    // session files, the same set is used for both session types
+    QVERIFY(m_sessionDir.isValid());
+    for (int i = 0; i < SESSION_COUNT; ++i) {
+        QFile session(m_sessionDir.filePath(QStringLiteral("session%1.desktop").arg(i)));
+        QVERIFY(session.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream(&session) << "[Desktop Entry]\n"
+                              << "Name=Session " << i << "\n"
+                              << "Comment=Benchmark session\n"
+                              << "Exec=/bin/true\n"
+                              << "TryExec=/bin/true\n"
+                              << "Type=Application\n"
+                              << "DesktopNames=Bench\n";
+    }
+    mainConfig.X11.SessionDir.set(m_sessionDir.path());
+    mainConfig.Wayland.SessionDir.set(m_sessionDir.path());
+}
+
+void Benchmark::cleanupTestCase() {
+    QFile::remove(BENCH_CONF_FILE);
+}
+
+void Benchmark::configLoad() {
+    BenchConfig config;
+    QBENCHMARK {
+        config.load();
+    }
+    QCOMPARE(config.Int.get(), 7);
+}
+
+void Benchmark::configSave() {
+    BenchConfig config;
+    int i = 0;
+    QBENCHMARK {
+        config.Second.Int.set(++i);
+        config.save();
+    }
+}
+
+void Benchmark::sessionSetTo() {
+    Session session;
+    QBENCHMARK {
+        session.setTo(Session::X11Session, QStringLiteral("session0.desktop"));
+    }
+    QVERIFY(session.isValid());
+}
+
+void Benchmark::sessionModelPopulate() {
+    QBENCHMARK {
+        SessionModel model;
+        QCOMPARE(model.rowCount(), SESSION_COUNT * 2);
+    }
+}
+
+void Benchmark::userModelConstruction() {
+    QBENCHMARK {
+        UserModel model(true);
+        // users are only enumerated once the model is first queried
+        QVERIFY(model.rowCount() >= 0);
+    }
+}
+
+void Benchmark::requestRoundTrip() {
+    Request request({ Prompt(AuthPrompt::LOGIN_USER, QStringLiteral("Login"), false),
+                      Prompt(AuthPrompt::LOGIN_PASSWORD, QStringLiteral("Password"), true) });
+    Request result;
+
+    QBENCHMARK {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << request;
+        QDataStream in(data);
+        in >> result;
+    }
+    QCOMPARE(result, request);
+}
+
+void Benchmark::promptRoundTrip() {
+    Prompt prompt(AuthPrompt::LOGIN_PASSWORD, QStringLiteral("Password"), true);
+    prompt.response = QByteArrayLiteral("secret");
+    Prompt result;
+
+    QBENCHMARK {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << prompt;
+        QDataStream in(data);
+        in >> result;
+    }
+    QCOMPARE(result, prompt);
+}
+
+void Benchmark::environmentRoundTrip() {
+    // roughly the size of a session environment
+    QProcessEnvironment env;
+    for (int i = 0; i < 40; ++i)
+        env.insert(QStringLiteral("VARIABLE_%1").arg(i), QStringLiteral("/usr/local/bin:/usr/bin:/bin:%1").arg(i));
+
+    QProcessEnvironment result;
+    QBENCHMARK {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << env;
+        QDataStream in(data);
+        result = QProcessEnvironment();
+        in >> result;
+    }
+    QCOMPARE(result, env);
+}
+
+void Benchmark::safeDataStreamFraming() {
+    int fds[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    QLocalSocket writer, reader;
+    QVERIFY(writer.setSocketDescriptor(fds[0]));
+    QVERIFY(reader.setSocketDescriptor(fds[1]));
+
+    SafeDataStream out(&writer);
+    SafeDataStream in(&reader);
+    const QByteArray payload(4096, 'x');
+
+    QBENCHMARK {
+        out << AUTHENTICATED << QStringLiteral("user") << payload;
+        out.send();
+
+        in.receive();
+        Msg m = MSG_UNKNOWN;
+        QString user;
+        QByteArray data;
+        in >> m >> user >> data;
+        QCOMPARE(m, AUTHENTICATED);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * Micro-benchmarks of parsing and serialization hot paths
+ * Copyright (C) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include "ConfigReader.h"
+
+#define BENCH_CONF_FILE QStringLiteral("bench.conf")
+
+Config (BenchConfig, BENCH_CONF_FILE, QString(), QString(),
+    Entry(    String,         QString,  _S("Benchmark"), _S("String entry"));
+    Entry(       Int,             int,            42, _S("Integer entry"));
+    Entry(StringList,     QStringList, QStringList(), _S("String list entry"));
+    Section(First,
+        Entry(    String,         QString,  _S("Benchmark"), _S("String entry"));
+        Entry(   Boolean,            bool,          true, _S("Boolean entry"));
+    );
+    Section(Second,
+        Entry(    String,         QString,  _S("Benchmark"), _S("String entry"));
+        Entry(       Int,             int,            42, _S("Integer entry"));
+    );
+);
+
+class Benchmark : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void configLoad();
+    void configSave();
+    void sessionSetTo();
+    void sessionModelPopulate();
+    void userModelConstruction();
+    void requestRoundTrip();
+    void promptRoundTrip();
+    void environmentRoundTrip();
+    void safeDataStreamFraming();
+
+private:
+    QTemporaryDir m_sessionDir;
+};
+
+#endif // BENCHMARK_H
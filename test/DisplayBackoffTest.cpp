@@ -0,0 +1,77 @@
+/*
+ * Display restart back-off tests
+ * Copyright (C) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "DisplayBackoffTest.h"
+
+#include "DisplayBackoff.h"
+
+#include <QtTest/QtTest>
+
+using namespace SDDM;
+
+QTEST_GUILESS_MAIN(DisplayBackoffTest);
+
+void DisplayBackoffTest::AutologinDiesRightAway() {
+    // an autologin or relogin session that exits at once takes the
+    // display down with it, that has to back off like a crashing X server
+    DisplayBackoff backoff;
+    QCOMPARE(backoff.restartDelay(), qint64(0));
+
+    QVERIFY(backoff.displayStopped(2000, false));
+    QCOMPARE(backoff.restartDelay(), qint64(1000));
+    QVERIFY(backoff.displayStopped(2000, false));
+    QCOMPARE(backoff.restartDelay(), qint64(2000));
+    QVERIFY(!backoff.isCrashLooping());
+
+    for (int i = 0; i < 3; ++i)
+        QVERIFY(backoff.displayStopped(2000, false));
+    QCOMPARE(backoff.failures(), 5);
+    QCOMPARE(backoff.restartDelay(), qint64(16000));
+    QVERIFY(backoff.isCrashLooping());
+}
+
+void DisplayBackoffTest::GreeterLoginResets() {
+    // users may log out right after logging in from the greeter
+    DisplayBackoff backoff;
+    for (int i = 0; i < 5; ++i)
+        backoff.displayStopped(2000, false);
+    QVERIFY(backoff.isCrashLooping());
+
+    QVERIFY(!backoff.displayStopped(2000, true));
+    QCOMPARE(backoff.failures(), 0);
+    QCOMPARE(backoff.restartDelay(), qint64(0));
+    QVERIFY(!backoff.isCrashLooping());
+}
+
+void DisplayBackoffTest::LongLivedDisplayResets() {
+    DisplayBackoff backoff;
+    backoff.displayStopped(2000, false);
+    backoff.displayStopped(2000, false);
+
+    QVERIFY(!backoff.displayStopped(60000, false));
+    QCOMPARE(backoff.restartDelay(), qint64(0));
+}
+
+void DisplayBackoffTest::DelayIsCapped() {
+    DisplayBackoff backoff;
+    for (int i = 0; i < 40; ++i)
+        backoff.displayStopped(0, false);
+    QCOMPARE(backoff.restartDelay(), qint64(60000));
+}
@@ -0,0 +1,409 @@
+/*
+ * End-to-end login load test
+ * Copyright (C) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LoadTest.h"
+
+#include "Messages.h"
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusInterface>
+#include <QtDBus/QDBusReply>
+#include <QtNetwork/QLocalSocket>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace SDDM;
+
+static QString env(const char *name)
+{
+    return QString::fromLocal8Bit(qgetenv(name));
+}
+
+/***************************************************************************
+ * Scripted greeter
+ ***************************************************************************/
+
+ScriptedGreeter::ScriptedGreeter(const QString &socket, QObject *parent) : QObject(parent)
+{
+    m_socket = new QLocalSocket(this);
+    connect(m_socket, &QLocalSocket::connected, this, &ScriptedGreeter::connected);
+    connect(m_socket, &QLocalSocket::readyRead, this, &ScriptedGreeter::readyRead);
+    connect(m_socket, QOverload<QLocalSocket::LocalSocketError>::of(&QLocalSocket::error), this, &ScriptedGreeter::error);
+    m_socket->connectToServer(socket);
+}
+
+void ScriptedGreeter::connected()
+{
+    QByteArray data;
+    QDataStream output(&data, QIODevice::WriteOnly);
+
+    // same framing as GreeterProxy, the session is sent as type and file name
+    output << quint32(GreeterMessages::Connect);
+    output << quint32(GreeterMessages::Login) << env("SDDM_LOADTEST_USER") << env("SDDM_LOADTEST_PASSWORD")
+           << quint32(1) << env("SDDM_LOADTEST_SESSION");
+
+    m_timer.start();
+    m_socket->write(data);
+    m_socket->flush();
+}
+
+void ScriptedGreeter::readyRead()
+{
+    QDataStream input(m_socket);
+
+    while (input.device()->bytesAvailable()) {
+        quint32 message;
+        input >> message;
+
+        switch (DaemonMessages(message)) {
+            case DaemonMessages::Capabilities: {
+                quint32 capabilities;
+                input >> capabilities;
+            }
+            break;
+            case DaemonMessages::HostName: {
+                QString hostName;
+                input >> hostName;
+            }
+            break;
+            case DaemonMessages::LoginSucceeded:
+                report(true);
+                return;
+            case DaemonMessages::LoginFailed:
+                report(false);
+                return;
+            case DaemonMessages::PowerActionFinished: {
+                quint32 action, success;
+                QString error;
+                input >> action >> success >> error;
+            }
+            break;
+            case DaemonMessages::StayResident:
+            case DaemonMessages::Reset:
+                break;
+            default:
+                // the payload size is unknown, everything after it would be garbage
+                qCritical() << "Unexpected message received from daemon:" << message;
+                report(false);
+                return;
+        }
+    }
+}
+
+void ScriptedGreeter::error()
+{
+    qCritical() << "Socket error:" << m_socket->errorString();
+    QCoreApplication::exit(1);
+}
+
+void ScriptedGreeter::report(bool success)
+{
+    QFile file(env("SDDM_LOADTEST_RESULTS"));
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        QTextStream(&file) << (success ? "ok " : "fail ") << m_timer.elapsed() << "\n";
+        file.close();
+    }
+
+    QCoreApplication::exit(success ? 0 : 1);
+}
+
+/***************************************************************************
+ * Load test driver
+ ***************************************************************************/
+
+LoadTest::LoadTest(const LoadTestOptions &options, QObject *parent) : QObject(parent), m_options(options)
+{
+    m_workDir = QDir::temp().filePath(QStringLiteral("sddm-loadtest-%1").arg(QCoreApplication::applicationPid()));
+    m_sampleTimer.setInterval(1000);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &LoadTest::sample);
+}
+
+LoadTest::~LoadTest()
+{
+    for (Instance &instance : m_instances) {
+        for (QProcess *process : { instance.daemon, instance.bus }) {
+            if (!process)
+                continue;
+            process->terminate();
+            if (!process->waitForFinished(5000))
+                process->kill();
+        }
+    }
+
+    if (m_xvfb) {
+        m_xvfb->terminate();
+        m_xvfb->waitForFinished(5000);
+    }
+}
+
+bool LoadTest::start()
+{
+    if (!QDir().mkpath(m_workDir)) {
+        qCritical() << "Failed to create" << m_workDir;
+        return false;
+    }
+
+    // Xephyr needs a host display, provide one if we are headless
+    if (!m_options.xvfbPath.isEmpty() && !startXvfb())
+        return false;
+
+    m_instances.resize(m_options.instances);
+    for (int i = 0; i < m_instances.size(); ++i) {
+        if (!startInstance(m_instances[i], i))
+            return false;
+    }
+
+    qInfo() << "Started" << m_instances.size() << "daemons, results in" << m_workDir;
+
+    m_elapsed.start();
+    m_sampleTimer.start();
+    return true;
+}
+
+bool LoadTest::startXvfb()
+{
+    int display = 50;
+    while (QFile::exists(QStringLiteral("/tmp/.X11-unix/X%1").arg(display)))
+        ++display;
+
+    m_xvfb = new QProcess(this);
+    m_xvfb->start(m_options.xvfbPath, { QStringLiteral(":%1").arg(display),
+                                        QStringLiteral("-screen"), QStringLiteral("0"), QStringLiteral("1600x1200x24"),
+                                        QStringLiteral("-nolisten"), QStringLiteral("tcp") });
+    if (!m_xvfb->waitForStarted()) {
+        qCritical() << "Failed to start" << m_options.xvfbPath;
+        return false;
+    }
+
+    // wait for the socket to show up
+    for (int i = 0; i < 50 && !QFile::exists(QStringLiteral("/tmp/.X11-unix/X%1").arg(display)); ++i)
+        QThread::msleep(100);
+
+    qputenv("DISPLAY", QStringLiteral(":%1").arg(display).toLocal8Bit());
+    return true;
+}
+
+bool LoadTest::startInstance(Instance &instance, int index)
+{
+    const QString dir = QStringLiteral("%1/instance%2").arg(m_workDir).arg(index);
+    QDir().mkpath(dir);
+
+    // private bus, the daemon exports its objects on the session bus in test mode
+    instance.bus = new QProcess(this);
+    instance.bus->start(QStringLiteral("dbus-daemon"), { QStringLiteral("--session"), QStringLiteral("--nofork"), QStringLiteral("--print-address=1") });
+    if (!instance.bus->waitForStarted() || !instance.bus->waitForReadyRead(5000)) {
+        qCritical() << "Failed to start a private bus";
+        return false;
+    }
+    instance.busAddress = QString::fromLocal8Bit(instance.bus->readLine()).trimmed();
+    instance.results = QStringLiteral("%1/results").arg(dir);
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert(QStringLiteral("DBUS_SESSION_BUS_ADDRESS"), instance.busAddress);
+    env.insert(QStringLiteral("SDDM_TEST_GREETER"), QCoreApplication::applicationFilePath());
+    env.insert(QStringLiteral("SDDM_LOADTEST_USER"), m_options.user);
+    env.insert(QStringLiteral("SDDM_LOADTEST_PASSWORD"), m_options.password);
+    env.insert(QStringLiteral("SDDM_LOADTEST_SESSION"), m_options.session);
+    env.insert(QStringLiteral("SDDM_LOADTEST_RESULTS"), instance.results);
+
+    // the daemon writes the X authority file to its working directory in test mode
+    instance.daemon = new QProcess(this);
+    instance.daemon->setProcessEnvironment(env);
+    instance.daemon->setWorkingDirectory(dir);
+    instance.daemon->setProcessChannelMode(QProcess::MergedChannels);
+    instance.daemon->setStandardOutputFile(QStringLiteral("%1/sddm.log").arg(dir));
+    instance.daemon->start(m_options.daemonPath, { QStringLiteral("--test-mode") });
+    if (!instance.daemon->waitForStarted()) {
+        qCritical() << "Failed to start" << m_options.daemonPath;
+        return false;
+    }
+
+    // give Xephyr time to claim its display before the next daemon looks for a free one
+    QThread::msleep(2000);
+
+    return true;
+}
+
+void LoadTest::sample()
+{
+    bool done = true;
+
+    for (Instance &instance : m_instances) {
+        // resident set size of the daemon
+        QFile status(QStringLiteral("/proc/%1/status").arg(instance.daemon->processId()));
+        if (status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            const QList<QByteArray> lines = status.readAll().split('\n');
+            for (const QByteArray &line : lines) {
+                if (line.startsWith("VmRSS:")) {
+                    instance.rss << line.mid(6).trimmed().split(' ').first().toLongLong();
+                    break;
+                }
+            }
+        }
+
+        int failures = 0;
+        if (readResults(instance, &failures).size() + failures < m_options.iterations)
+            done = false;
+    }
+
+    if (done || m_elapsed.elapsed() > m_options.timeout * 1000)
+        finish();
+}
+
+QVector<qint64> LoadTest::readResults(const Instance &instance, int *failures) const
+{
+    QVector<qint64> latencies;
+
+    QFile file(instance.results);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return latencies;
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QStringList fields = in.readLine().split(QLatin1Char(' '));
+        if (fields.size() != 2)
+            continue;
+        if (fields.at(0) == QLatin1String("ok"))
+            latencies << fields.at(1).toLongLong();
+        else
+            ++*failures;
+    }
+
+    return latencies;
+}
+
+void LoadTest::printMetrics(const Instance &instance, int index) const
+{
+    QDBusConnection connection = QDBusConnection::connectToBus(instance.busAddress, QStringLiteral("loadtest%1").arg(index));
+    QDBusInterface metrics(QStringLiteral("org.freedesktop.DisplayManager"), QStringLiteral("/org/freedesktop/DisplayManager"),
+                           QStringLiteral("org.sddm.Metrics"), connection);
+
+    QDBusReply<QVariantMap> reply = metrics.call(QStringLiteral("Counters"));
+    if (!reply.isValid()) {
+        qWarning() << "  metrics unavailable:" << reply.error().message();
+        return;
+    }
+
+    const QVariantMap counters = reply.value();
+    for (auto it = counters.constBegin(); it != counters.constEnd(); ++it)
+        qInfo().noquote() << QStringLiteral("  %1: %2").arg(it.key()).arg(it.value().toULongLong());
+}
+
+void LoadTest::finish()
+{
+    m_sampleTimer.stop();
+
+    QVector<qint64> latencies;
+    int failures = 0;
+
+    for (int i = 0; i < m_instances.size(); ++i) {
+        const Instance &instance = m_instances.at(i);
+        latencies += readResults(instance, &failures);
+
+        qint64 peak = 0;
+        for (qint64 rss : instance.rss)
+            peak = qMax(peak, rss);
+
+        qInfo().noquote() << QStringLiteral("Instance %1: RSS first %2 kB, peak %3 kB, last %4 kB over %5 samples")
+                             .arg(i)
+                             .arg(instance.rss.isEmpty() ? 0 : instance.rss.first())
+                             .arg(peak)
+                             .arg(instance.rss.isEmpty() ? 0 : instance.rss.last())
+                             .arg(instance.rss.size());
+        printMetrics(instance, i);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    // nearest-rank percentile
+    auto percentile = [&latencies](double p) -> qint64 {
+        if (latencies.isEmpty())
+            return 0;
+        int rank = int(std::ceil(p / 100.0 * latencies.size()));
+        return latencies.at(qBound(0, rank - 1, latencies.size() - 1));
+    };
+
+    qInfo().noquote() << QStringLiteral("Logins: %1 succeeded, %2 failed in %3 s")
+                         .arg(latencies.size()).arg(failures).arg(m_elapsed.elapsed() / 1000);
+    qInfo().noquote() << QStringLiteral("Login latency: p50 %1 ms, p90 %2 ms, p99 %3 ms, max %4 ms")
+                         .arg(percentile(50)).arg(percentile(90)).arg(percentile(99))
+                         .arg(latencies.isEmpty() ? 0 : latencies.last());
+
+    QCoreApplication::exit(failures == 0 && !latencies.isEmpty() ? 0 : 1);
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    // started by the daemon in place of sddm-greeter
+    const QStringList arguments = app.arguments();
+    int socketIndex = arguments.indexOf(QStringLiteral("--socket"));
+    if (socketIndex != -1 && socketIndex + 1 < arguments.size()) {
+        ScriptedGreeter greeter(arguments.at(socketIndex + 1));
+        return app.exec();
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Runs repeated logins against sddm in test mode and reports latency and memory usage.\n"
+                                                    "Must run as root, the session should exit right away so that the next greeter comes up."));
+    parser.addHelpOption();
+    QCommandLineOption daemonOption(QStringLiteral("daemon"), QStringLiteral("Path to the sddm binary."), QStringLiteral("path"), QStringLiteral("sddm"));
+    QCommandLineOption xvfbOption(QStringLiteral("xvfb"), QStringLiteral("Start this Xvfb binary to host the nested displays."), QStringLiteral("path"));
+    QCommandLineOption userOption(QStringLiteral("user"), QStringLiteral("User to log in as."), QStringLiteral("name"));
+    QCommandLineOption passwordOption(QStringLiteral("password"), QStringLiteral("Password of the user."), QStringLiteral("password"));
+    QCommandLineOption sessionOption(QStringLiteral("session"), QStringLiteral("X session file to start."), QStringLiteral("file"));
+    QCommandLineOption instancesOption(QStringLiteral("instances"), QStringLiteral("Number of concurrent daemons."), QStringLiteral("count"), QStringLiteral("1"));
+    QCommandLineOption iterationsOption(QStringLiteral("iterations"), QStringLiteral("Logins per daemon."), QStringLiteral("count"), QStringLiteral("10"));
+    QCommandLineOption timeoutOption(QStringLiteral("timeout"), QStringLiteral("Give up after this many seconds."), QStringLiteral("seconds"), QStringLiteral("600"));
+    parser.addOptions({ daemonOption, xvfbOption, userOption, passwordOption, sessionOption,
+                        instancesOption, iterationsOption, timeoutOption });
+    parser.process(app);
+
+    if (!parser.isSet(userOption) || !parser.isSet(sessionOption)) {
+        qCritical() << "--user and --session are required";
+        return 1;
+    }
+
+    LoadTestOptions options;
+    options.daemonPath = parser.value(daemonOption);
+    options.xvfbPath = parser.value(xvfbOption);
+    options.user = parser.value(userOption);
+    options.password = parser.value(passwordOption);
+    options.session = parser.value(sessionOption);
+    options.instances = qMax(1, parser.value(instancesOption).toInt());
+    options.iterations = qMax(1, parser.value(iterationsOption).toInt());
+    options.timeout = qMax(1, parser.value(timeoutOption).toInt());
+
+    LoadTest test(options);
+    if (!test.start())
+        return 1;
+
+    return app.exec();
+}
@@ -0,0 +1,108 @@
+/*
+ * End-to-end login load test
+ * Copyright (C) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LOADTEST_H
+#define LOADTEST_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+class QLocalSocket;
+
+/**
+ * Stands in for sddm-greeter. It is started by a daemon running in
+ * test mode, logs in once with the credentials found in the environment
+ * and appends the measured latency to the results file.
+ */
+class ScriptedGreeter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ScriptedGreeter(const QString &socket, QObject *parent = 0);
+
+private slots:
+    void connected();
+    void readyRead();
+    void error();
+
+private:
+    void report(bool success);
+
+    QLocalSocket *m_socket { nullptr };
+    QElapsedTimer m_timer;
+};
+
+struct LoadTestOptions
+{
+    QString daemonPath { QStringLiteral("sddm") };
+    QString xvfbPath;
+    QString user;
+    QString password;
+    QString session;
+    int instances { 1 };
+    int iterations { 10 };
+    int timeout { 600 };
+};
+
+/**
+ * Starts several daemons in test mode, each one on its own private
+ * bus, lets scripted greeters log in repeatedly and reports login
+ * latency percentiles together with the daemon memory usage.
+ */
+class LoadTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LoadTest(const LoadTestOptions &options, QObject *parent = 0);
+    ~LoadTest();
+
+    bool start();
+
+private slots:
+    void sample();
+    void finish();
+
+private:
+    struct Instance {
+        QProcess *bus { nullptr };
+        QProcess *daemon { nullptr };
+        QString busAddress;
+        QString results;
+        QVector<qint64> rss;
+    };
+
+    bool startXvfb();
+    bool startInstance(Instance &instance, int index);
+    QVector<qint64> readResults(const Instance &instance, int *failures) const;
+    void printMetrics(const Instance &instance, int index) const;
+
+    LoadTestOptions m_options;
+    QProcess *m_xvfb { nullptr };
+    QVector<Instance> m_instances;
+    QTimer m_sampleTimer;
+    QElapsedTimer m_elapsed;
+    QString m_workDir;
+};
+
+#endif // LOADTEST_H
@@ -0,0 +1,83 @@
+/*
+ * Login retry delay tests
+ * Copyright (C) 2021 Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LoginLimiterTest.h"
+
+#include "Configuration.h"
+#include "LoginLimiter.h"
+
+#include <QtTest/QtTest>
+
+using namespace SDDM;
+
+QTEST_GUILESS_MAIN(LoginLimiterTest);
+
+void LoginLimiterTest::init() {
+    mainConfig.Users.LoginRetryDelay.set(1);
+    mainConfig.Users.LoginRetryMaxDelay.set(60);
+}
+
+void LoginLimiterTest::FreeAttempts() {
+    LoginLimiter limiter;
+    limiter.failed(QStringLiteral("alice"));
+    limiter.failed(QStringLiteral("alice"));
+    QCOMPARE(limiter.delay(QStringLiteral("alice")), qint64(0));
+}
+
+void LoginLimiterTest::RepeatedWrongPasswords() {
+    // failures are recorded under the name the greeter logged in with,
+    // the next attempt of that user has to wait
+    LoginLimiter limiter;
+    for (int i = 0; i < 3; ++i)
+        limiter.failed(QStringLiteral("alice"));
+    QVERIFY(limiter.delay(QStringLiteral("alice")) > 0);
+    QVERIFY(limiter.delay(QStringLiteral("alice")) <= 1000);
+
+    // every further failure doubles the delay
+    limiter.failed(QStringLiteral("alice"));
+    QVERIFY(limiter.delay(QStringLiteral("alice")) > 1000);
+
+    // other users are not affected before the seat limit
+    QCOMPARE(limiter.delay(QStringLiteral("bob")), qint64(0));
+}
+
+void LoginLimiterTest::SuccessResets() {
+    LoginLimiter limiter;
+    for (int i = 0; i < 5; ++i)
+        limiter.failed(QStringLiteral("alice"));
+    limiter.succeeded(QStringLiteral("alice"));
+    QCOMPARE(limiter.delay(QStringLiteral("alice")), qint64(0));
+}
+
+void LoginLimiterTest::SeatLimit() {
+    // guessing across many user names throttles the whole seat
+    LoginLimiter limiter;
+    for (int i = 0; i < 10; ++i)
+        limiter.failed(QStringLiteral("user%1").arg(i));
+    QVERIFY(limiter.delay(QStringLiteral("carol")) > 0);
+}
+
+void LoginLimiterTest::Disabled() {
+    mainConfig.Users.LoginRetryDelay.set(0);
+    LoginLimiter limiter;
+    for (int i = 0; i < 20; ++i)
+        limiter.failed(QStringLiteral("alice"));
+    QCOMPARE(limiter.delay(QStringLiteral("alice")), qint64(0));
+}